@@ -1,112 +1,2627 @@
 #include "gpio_misc_driver.h"
 
 #define ALIVE_BASE	160
+#define GPIO_MISC_MAX_PINS	32
+
+/* edge events buffered per open(), must be a power of 2 */
+#define GPIO_MISC_EVENTS	512
+
+/* header page plus records of the mmap() ring */
+#define GPIO_MISC_RING_BYTES	PAGE_ALIGN(PAGE_SIZE + \
+	GPIO_MISC_RING_RECORDS * sizeof(struct gpio_misc_event))
+
+/* software PWM limits, edges closer than the slack share one register write */
+#define GPIO_MISC_PWM_MIN_PERIOD_NS	20000
+#define GPIO_MISC_PWM_SLACK_NS		2000
+
+/* log2 buckets of the IRQ latency histograms, the last one is open ended */
+#define GPIO_MISC_LAT_BUCKETS	32
+
+enum {
+	GPIO_MISC_LAT_TOP,	/* top half entry to exit */
+	GPIO_MISC_LAT_WAKE,	/* top half exit to thread entry */
+	GPIO_MISC_LAT_TOTAL,	/* top half entry to thread exit */
+	GPIO_MISC_LAT_KINDS,
+};
+
+/* number of get/set loops timed at probe, 0 disables the benchmark */
+static unsigned int bench_loops;
+module_param(bench_loops, uint, 0444);
+MODULE_PARM_DESC(bench_loops, "register access benchmark loops at probe");
+
+struct driver_data;
+
+/*
+ * One per physical alive block, shared by every device node that maps
+ * it. Pin updates go through the SET/RESET registers without a lock,
+ * the lock only covers the pin claims.
+ */
+struct misc_gpio_bank {
+	struct list_head node;
+	struct kref ref;
+	u32 addr;
+	struct nx_alive_gpio_regs __iomem *regs;
+	spinlock_t lock;
+	u32 claimed;		/* pins owned by a device */
+};
+
+static LIST_HEAD(misc_gpio_banks);
+static DEFINE_MUTEX(misc_gpio_banks_lock);
+
+/* probed devices by misc name, and the configfs pins attached to them */
+static LIST_HEAD(misc_gpio_devices);
+static DEFINE_MUTEX(misc_gpio_devices_lock);
+
+/* what a pin slot is used for, DT pins are inputs */
+enum {
+	GPIO_MISC_MODE_INPUT,	/* edge events and capture */
+	GPIO_MISC_MODE_OUTPUT,
+	GPIO_MISC_MODE_PWM,
+	GPIO_MISC_MODE_CAPTURE,	/* both edges, capture only, no events */
+	GPIO_MISC_MODES,
+};
+
+static const char * const misc_gpio_mode_names[GPIO_MISC_MODES] = {
+	[GPIO_MISC_MODE_INPUT]   = "input",
+	[GPIO_MISC_MODE_OUTPUT]  = "output",
+	[GPIO_MISC_MODE_PWM]     = "pwm",
+	[GPIO_MISC_MODE_CAPTURE] = "capture",
+};
+
+struct misc_gpio_cfs_pin;
+
+/* waveform buffer copied from user space */
+struct misc_gpio_wave_buf {
+	u32 nsteps;
+	u32 flags;
+	struct gpio_misc_wave_step steps[];
+};
+
+/* one alive pin channel of a device, slots with no plat_data are free */
+struct misc_gpio_pin {
+	struct driver_data *plat_data;
+	int id;
+	int irq;
+	int mode;			/* GPIO_MISC_MODE_* */
+	struct misc_gpio_cfs_pin *cfs;	/* configfs owner, NULL for DT pins */
+
+	/* pulse capture, updated by the top half under event_lock */
+	u64 edges;
+	u64 rise_ns;
+	u64 fall_ns;
+	u64 period_ns;
+	u64 high_ns;
+	u64 width_min_ns;
+	u64 width_max_ns;
+	u64 width_sum_ns;
+	u64 widths;
+
+	/* oldest edge the thread has not handled yet, under event_lock */
+	u64 irq_ns;
+	u64 wake_ns;
+
+	u64 wake_last_ns;	/* boot time of its last system wake */
+};
+
+/* software PWM channel, drives the pin of the same index */
+struct misc_gpio_pwm {
+	u64 period_ns;
+	u64 duty_ns;
+	u64 start_ns;		/* start of the current period */
+	u64 next_ns;		/* next edge while queued */
+	bool rising;		/* the next edge starts a period */
+	bool enabled;
+};
+
+/* per-CPU IRQ latency counters, bucket b counts [2^(b-1), 2^b) ns */
+struct misc_gpio_lat {
+	u32 hist[GPIO_MISC_LAT_KINDS][GPIO_MISC_LAT_BUCKETS];
+	u64 max_ns[GPIO_MISC_LAT_KINDS];
+};
 
 /* platform data format */
 struct driver_data {
+	/* waveform engine, htimer plays wave_cur with wave_next queued */
 	struct hrtimer htimer;
-	ktime_t ktime;
+	spinlock_t wave_lock;
+	struct misc_gpio_wave_buf *wave_cur;	/* playing, or played out */
+	struct misc_gpio_wave_buf *wave_next;
+	struct misc_gpio_wave_buf *wave_old;	/* retired, freed in process context */
+	unsigned int wave_pos;
+	struct gpio_misc_wave_stats wave_stats;
+
+	/*
+	 * software PWM, pwm_timer plays the edges of the enabled channels
+	 * from pwm_queue, which holds channel indexes sorted by next_ns
+	 */
+	struct pwm_chip pwm_chip;
+	struct hrtimer pwm_timer;
+	spinlock_t pwm_lock;
+	struct misc_gpio_pwm pwm[GPIO_MISC_MAX_PINS];
+	u8 pwm_queue[GPIO_MISC_MAX_PINS];
+	unsigned int pwm_nqueued;
+	u64 pwm_ticks;		/* timer expiries */
+	u64 pwm_writes;		/* batched register updates */
+	u64 pwm_missed;		/* periods skipped after falling behind */
+
+	const char *name;
+	u32 addr;
+	struct list_head node;	/* on misc_gpio_devices */
+
+	int npins;		/* slots in use, configfs pins may leave holes */
+	struct misc_gpio_pin pins[GPIO_MISC_MAX_PINS];
+	u32 pin_mask;		/* pins this device may drive */
+	struct device *dev;
+	struct miscdevice mdev;
+
+	struct misc_gpio_bank *bank;
+	struct nx_alive_gpio_regs __iomem *palive_gpio;	/* bank->regs */
+
+	/*
+	 * edge events: the pin top halves serialize on event_lock for the
+	 * sequence number and the ring, then fan out to the open() queues
+	 * on the RCU client list without it
+	 */
+	spinlock_t event_lock;
+	struct mutex read_lock;
+	struct mutex clients_lock;	/* writers of clients */
+	struct list_head clients;
+	wait_queue_head_t wait;
+	u32 seq;
+	u32 overflow;		/* ring drops since the last ring record */
+
+	/*
+	 * mmap() ring, filled next to the open() queues while user space
+	 * has it mapped, a ring consumer can filter out its own queue
+	 */
+	struct gpio_misc_ring_header *ring;
+	struct gpio_misc_event *ring_records;
+	u32 ring_head;
+	atomic_t ring_users;
+
+	/* pad sampler, runs of the masked pad register in a vmalloc ring */
+	struct hrtimer stimer;
+	struct mutex sample_lock;
+	struct gpio_misc_sample_run *runs;
+	u32 run_head;		/* runs written, the last one is growing */
+	u32 sample_mask;
+	u32 sample_rate;
+	u64 sample_period_ns;
+	u64 sample_missed;	/* periods lost to timer overruns */
+	bool sampling;
+
+	struct misc_gpio_lat __percpu *lat;
+
+	/* register snapshot of the managed pins, taken at suspend */
+	u32 pm_out;
+	u32 pm_outenb;
+	u32 pm_detmode[NX_ALIVE_DET_MODES];
+	u32 pm_detenb;
+	u32 pm_intenb;
+	u64 pm_restore_ns;	/* duration of the last restore */
+	u64 suspend_boot_ns;	/* boot time at suspend_noirq */
+
+	/* system wakeup, config and log under wake_lock */
+	struct mutex wake_lock;
+	u32 wake_mask;		/* pins user space wants as wake sources */
+	u32 wake_armed;		/* pins with irq wake on for this suspend */
+	u64 wake_holdoff_ns;
+	u32 wake_held_off;
+	struct gpio_misc_wake_event wake_events[GPIO_MISC_WAKE_EVENTS];
+	u32 wake_head;		/* free running, like ring_head */
+	u32 wake_tail;
+	u32 wake_seq;
+	u32 wake_lost;
+
+	struct dentry *debugfs;
+
+	/* held by the device, open files and ring mappings */
+	struct kref ref;
+
+	/*
+	 * set by platform_remove under the write side, ioctl() and write()
+	 * run under the read side so none is past the check when remove
+	 * stops the timers and gives the pins back
+	 */
+	struct rw_semaphore dead_lock;
+	bool dead;
+};
+
+/* per open() state */
+struct misc_gpio_client {
+	struct driver_data *plat_data;
+
+	/*
+	 * private edge queue, filled by the top halves under ev_lock and
+	 * drained by read() under ev_read_lock
+	 */
+	struct list_head node;
+	struct rcu_head rcu;
+	DECLARE_KFIFO(events, struct gpio_misc_event, GPIO_MISC_EVENTS);
+	spinlock_t ev_lock;
+	struct mutex ev_read_lock;
+	u32 pin_filter;		/* read locklessly by the top halves */
+	u32 edge_filter;
+	u32 overflow;		/* drops since the last queued event */
+	u32 lost;		/* total drops, POLLPRI until read() */
+	u32 lost_seen;
+	struct fasync_struct *async_queue;	/* SIGIO for accepted events */
+
+	/* results of the last write() program, drained by read() */
+	struct mutex lock;
+	u32 samples[GPIO_MISC_PROG_MAX_INSNS];
+	unsigned int nsamples;
+	unsigned int sample_pos;
+};
+
+static inline struct driver_data *to_driver_data(struct file *file)
+{
+	struct misc_gpio_client *client = file->private_data;
+
+	return client->plat_data;
+}
+
+static void misc_gpio_data_put(struct driver_data *plat_data);
+
+/* misc driver fuction implementations */
+static int misc_gpio_open(struct inode *inode, struct file *file)
+{
+	struct misc_gpio_client *client;
+
+	client = kzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return -ENOMEM;
+
+	/* misc_open() leaves the miscdevice in private_data */
+	client->plat_data = container_of(file->private_data,
+					 struct driver_data, mdev);
+	mutex_init(&client->lock);
+	INIT_KFIFO(client->events);
+	spin_lock_init(&client->ev_lock);
+	mutex_init(&client->ev_read_lock);
+	client->pin_filter = U32_MAX;
+	client->edge_filter = GPIO_MISC_EDGE_MASK(GPIO_MISC_EDGE_FALLING) |
+			      GPIO_MISC_EDGE_MASK(GPIO_MISC_EDGE_RISING);
+	file->private_data = client;
+	kref_get(&client->plat_data->ref);
+
+	mutex_lock(&client->plat_data->clients_lock);
+	list_add_tail_rcu(&client->node, &client->plat_data->clients);
+	mutex_unlock(&client->plat_data->clients_lock);
+
+	return 0;
+}
+
+static int misc_gpio_fasync(int fd, struct file *file, int on)
+{
+	struct misc_gpio_client *client = file->private_data;
+
+	return fasync_helper(fd, file, on, &client->async_queue);
+}
+
+static int misc_gpio_close(struct inode *inodep, struct file *file)
+{
+    struct misc_gpio_client *client = file->private_data;
+    struct driver_data *plat_data = client->plat_data;
+
+    misc_gpio_fasync(-1, file, 0);
+
+    /* top halves may still be queueing into it until a grace period */
+    mutex_lock(&plat_data->clients_lock);
+    list_del_rcu(&client->node);
+    mutex_unlock(&plat_data->clients_lock);
+    kfree_rcu(client, rcu);
+    misc_gpio_data_put(plat_data);
+    return 0;
+}
+
+/* hand out the samples of the last program, returns 0 when none are left */
+static ssize_t misc_gpio_read_samples(struct misc_gpio_client *client,
+				      char __user *buf, size_t count)
+{
+	unsigned int n;
+
+	mutex_lock(&client->lock);
+	n = min_t(size_t, count / sizeof(u32),
+		  client->nsamples - client->sample_pos);
+	if (n && copy_to_user(buf, &client->samples[client->sample_pos],
+			      n * sizeof(u32))) {
+		mutex_unlock(&client->lock);
+		return -EFAULT;
+	}
+	client->sample_pos += n;
+	mutex_unlock(&client->lock);
+
+	return n * sizeof(u32);
+}
+
+/*
+ * Returns pending program samples first, otherwise blocks for edge
+ * events of this open() and drains as many whole events as fit in the
+ * buffer.
+ */
+static ssize_t misc_gpio_read(struct file *filp, char __user *buf,
+			   size_t count, loff_t *f_pos)
+{
+	struct misc_gpio_client *client = filp->private_data;
+	struct driver_data *plat_data = client->plat_data;
+	unsigned int copied;
+	ssize_t ret;
+	int err;
+
+	ret = misc_gpio_read_samples(client, buf, count);
+	if (ret)
+		return ret;
+
+	if (count < sizeof(struct gpio_misc_event))
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&client->ev_read_lock))
+		return -ERESTARTSYS;
+
+	while (kfifo_is_empty(&client->events)) {
+		mutex_unlock(&client->ev_read_lock);
+
+		if (filp->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		if (wait_event_interruptible(plat_data->wait,
+				!kfifo_is_empty(&client->events)))
+			return -ERESTARTSYS;
+
+		if (mutex_lock_interruptible(&client->ev_read_lock))
+			return -ERESTARTSYS;
+	}
+
+	err = kfifo_to_user(&client->events, buf, count, &copied);
+	client->lost_seen = READ_ONCE(client->lost);
+	mutex_unlock(&client->ev_read_lock);
+
+	return err ? err : copied;
+}
+
+/* POLLIN when events are queued, POLLPRI when this open() dropped some */
+static unsigned int misc_gpio_poll(struct file *filp, poll_table *wait)
+{
+	struct misc_gpio_client *client = filp->private_data;
+	struct driver_data *plat_data = client->plat_data;
+	unsigned int mask = 0;
+
+	poll_wait(filp, &plat_data->wait, wait);
+
+	if (!kfifo_is_empty(&client->events))
+		mask |= POLLIN | POLLRDNORM;
+	if (READ_ONCE(client->lost) != client->lost_seen)
+		mask |= POLLPRI;
+	if (atomic_read(&plat_data->ring_users) &&
+	    smp_load_acquire(&plat_data->ring->tail) != READ_ONCE(plat_data->ring_head))
+		mask |= POLLIN | POLLRDNORM;
+
+	return mask;
+}
+
+static void misc_gpio_vm_open(struct vm_area_struct *vma)
+{
+	struct driver_data *plat_data = vma->vm_private_data;
+
+	kref_get(&plat_data->ref);
+	atomic_inc(&plat_data->ring_users);
+}
+
+static void misc_gpio_vm_close(struct vm_area_struct *vma)
+{
+	struct driver_data *plat_data = vma->vm_private_data;
+
+	atomic_dec(&plat_data->ring_users);
+	misc_gpio_data_put(plat_data);
+}
+
+static const struct vm_operations_struct misc_gpio_vm_ops = {
+	.open  = misc_gpio_vm_open,
+	.close = misc_gpio_vm_close,
+};
+
+/* map the event ring, allocated on first use */
+static int misc_gpio_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct driver_data *plat_data = to_driver_data(filp);
+	struct gpio_misc_ring_header *ring;
+	int err;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start > GPIO_MISC_RING_BYTES)
+		return -EINVAL;
+
+	mutex_lock(&plat_data->read_lock);
+	if (!plat_data->ring) {
+		ring = vmalloc_user(GPIO_MISC_RING_BYTES);
+		if (!ring) {
+			mutex_unlock(&plat_data->read_lock);
+			return -ENOMEM;
+		}
+		ring->size = GPIO_MISC_RING_RECORDS;
+		ring->record_offset = PAGE_SIZE;
+		plat_data->ring_records = (void *)ring + PAGE_SIZE;
+		plat_data->ring = ring;
+	}
+	mutex_unlock(&plat_data->read_lock);
+
+	err = remap_vmalloc_range(vma, plat_data->ring, 0);
+	if (err)
+		return err;
+
+	vma->vm_private_data = plat_data;
+	vma->vm_ops = &misc_gpio_vm_ops;
+
+	/* the top half must see the ring before it sees a user */
+	smp_wmb();
+	misc_gpio_vm_open(vma);
+
+	return 0;
+}
+
+static int misc_gpio_prog_check(struct driver_data *plat_data,
+				const struct gpio_misc_insn *prog,
+				unsigned int ninsns)
+{
+	u64 budget = 0;
+	unsigned int i;
+
+	for (i = 0; i < ninsns; i++) {
+		const struct gpio_misc_insn *insn = &prog[i];
+
+		if (insn->op > GPIO_MISC_OP_SAMPLE ||
+		    insn->reserved[0] || insn->reserved[1] || insn->reserved[2] ||
+		    (insn->mask & ~plat_data->pin_mask))
+			return -EINVAL;
+
+		if (insn->op == GPIO_MISC_OP_DELAY_NS ||
+		    insn->op == GPIO_MISC_OP_WAIT_LEVEL)
+			budget += insn->arg;
+	}
+
+	/* the program busy waits with preemption off, keep it short */
+	return budget > GPIO_MISC_PROG_MAX_NS ? -E2BIG : 0;
+}
+
+static int misc_gpio_prog_run(struct driver_data *plat_data,
+			      struct misc_gpio_client *client,
+			      const struct gpio_misc_insn *prog,
+			      unsigned int ninsns)
+{
+	struct nx_alive_gpio_regs __iomem *regs = plat_data->palive_gpio;
+	unsigned int i, nsamples = 0;
+	u64 deadline, timeout;
+	int err = 0;
+
+	preempt_disable();
+	deadline = ktime_get_ns();
+
+	for (i = 0; i < ninsns && !err; i++) {
+		const struct gpio_misc_insn *insn = &prog[i];
+
+		switch (insn->op) {
+		case GPIO_MISC_OP_SET:
+			alive_gpio_set_values(regs, insn->mask, insn->mask);
+			break;
+		case GPIO_MISC_OP_CLEAR:
+			alive_gpio_set_values(regs, insn->mask, 0);
+			break;
+		case GPIO_MISC_OP_WRITE:
+			alive_gpio_set_values(regs, insn->mask, insn->value);
+			break;
+		case GPIO_MISC_OP_DELAY_NS:
+			deadline += insn->arg;
+			while (ktime_get_ns() < deadline)
+				cpu_relax();
+			break;
+		case GPIO_MISC_OP_WAIT_LEVEL:
+			timeout = ktime_get_ns() + insn->arg;
+			while (alive_gpio_get_values(regs, insn->mask) !=
+			       (insn->value & insn->mask)) {
+				if (ktime_get_ns() > timeout) {
+					err = -ETIMEDOUT;
+					break;
+				}
+				cpu_relax();
+			}
+			/* later delays count from the matching level */
+			deadline = ktime_get_ns();
+			break;
+		case GPIO_MISC_OP_SAMPLE:
+			client->samples[nsamples++] =
+				alive_gpio_get_values(regs, insn->mask);
+			break;
+		}
+	}
+
+	preempt_enable();
+
+	client->nsamples = err ? 0 : nsamples;
+	client->sample_pos = 0;
+
+	return err;
+}
+
+/* run a program of struct gpio_misc_insn, see gpio_misc_uapi.h */
+static ssize_t misc_gpio_write(struct file *file, const char __user *buf,
+			   size_t len, loff_t *ppos)
+{
+	struct misc_gpio_client *client = file->private_data;
+	struct driver_data *plat_data = client->plat_data;
+	unsigned int ninsns = len / sizeof(struct gpio_misc_insn);
+	struct gpio_misc_insn *prog;
+	int err;
+
+	if (!ninsns || ninsns > GPIO_MISC_PROG_MAX_INSNS ||
+	    len % sizeof(struct gpio_misc_insn))
+		return -EINVAL;
+
+	prog = memdup_user(buf, len);
+	if (IS_ERR(prog))
+		return PTR_ERR(prog);
+
+	down_read(&plat_data->dead_lock);
+	err = plat_data->dead ? -ENODEV :
+		misc_gpio_prog_check(plat_data, prog, ninsns);
+	if (!err) {
+		mutex_lock(&client->lock);
+		err = misc_gpio_prog_run(plat_data, client, prog, ninsns);
+		mutex_unlock(&client->lock);
+	}
+	up_read(&plat_data->dead_lock);
+
+	kfree(prog);
+
+	return err ? err : len;
+}
+
+static struct misc_gpio_pin *misc_gpio_find_pin(struct driver_data *plat_data,
+						u32 id)
+{
+	int i;
+
+	for (i = 0; i < plat_data->npins; i++)
+		if (plat_data->pins[i].plat_data && plat_data->pins[i].id == id)
+			return &plat_data->pins[i];
+
+	return NULL;
+}
+
+static void misc_gpio_capture_get(struct misc_gpio_pin *pin,
+				  struct gpio_misc_capture *cap)
+{
+	struct driver_data *plat_data = pin->plat_data;
+	unsigned long flags;
+	u64 sum, n;
+
+	spin_lock_irqsave(&plat_data->event_lock, flags);
+	cap->edges = pin->edges;
+	cap->period_ns = pin->period_ns;
+	cap->high_ns = pin->high_ns;
+	cap->width_min_ns = pin->width_min_ns;
+	cap->width_max_ns = pin->width_max_ns;
+	sum = pin->width_sum_ns;
+	n = pin->widths;
+	spin_unlock_irqrestore(&plat_data->event_lock, flags);
+
+	cap->width_avg_ns = n ? div64_u64(sum, n) : 0;
+	cap->duty_permille = cap->period_ns ?
+		div64_u64(cap->high_ns * 1000, cap->period_ns) : 0;
+	cap->pin = pin->id;
+}
+
+static void misc_gpio_capture_reset(struct driver_data *plat_data, u32 mask)
+{
+	struct misc_gpio_pin *pin;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&plat_data->event_lock, flags);
+	for (i = 0; i < plat_data->npins; i++) {
+		pin = &plat_data->pins[i];
+		if (!pin->plat_data || !(mask & BIT(pin->id)))
+			continue;
+
+		pin->edges = 0;
+		pin->rise_ns = 0;
+		pin->fall_ns = 0;
+		pin->period_ns = 0;
+		pin->high_ns = 0;
+		pin->width_min_ns = 0;
+		pin->width_max_ns = 0;
+		pin->width_sum_ns = 0;
+		pin->widths = 0;
+	}
+	spin_unlock_irqrestore(&plat_data->event_lock, flags);
+}
+
+static int misc_gpio_capture_ioctl(struct driver_data *plat_data,
+				   struct gpio_misc_capture __user *argp)
+{
+	struct gpio_misc_capture cap;
+	struct misc_gpio_pin *pin;
+
+	if (copy_from_user(&cap, argp, sizeof(cap)))
+		return -EFAULT;
+
+	pin = misc_gpio_find_pin(plat_data, cap.pin);
+	if (!pin)
+		return -EINVAL;
+
+	misc_gpio_capture_get(pin, &cap);
+
+	return copy_to_user(argp, &cap, sizeof(cap)) ? -EFAULT : 0;
+}
+
+static int misc_gpio_wave_submit(struct driver_data *plat_data,
+				 const struct gpio_misc_wave __user *argp)
+{
+	struct misc_gpio_wave_buf *buf, *stale[2] = { NULL, NULL };
+	struct gpio_misc_wave wave;
+	unsigned long flags;
+	bool start = false;
+	int err = 0;
+	u32 i;
+
+	if (copy_from_user(&wave, argp, sizeof(wave)))
+		return -EFAULT;
+
+	if (!wave.nsteps || wave.nsteps > GPIO_MISC_WAVE_MAX_STEPS ||
+	    (wave.flags & ~(GPIO_MISC_WAVE_LOOP | GPIO_MISC_WAVE_LAST)))
+		return -EINVAL;
+
+	buf = vmalloc(sizeof(*buf) + wave.nsteps * sizeof(buf->steps[0]));
+	if (!buf)
+		return -ENOMEM;
+
+	buf->nsteps = wave.nsteps;
+	buf->flags = wave.flags;
+	if (copy_from_user(buf->steps, (void __user *)(uintptr_t)wave.steps,
+			   wave.nsteps * sizeof(buf->steps[0]))) {
+		vfree(buf);
+		return -EFAULT;
+	}
+
+	for (i = 0; i < buf->nsteps; i++) {
+		if (buf->steps[i].duration_ns < GPIO_MISC_WAVE_MIN_NS ||
+		    buf->steps[i].reserved ||
+		    (buf->steps[i].mask & ~plat_data->pin_mask)) {
+			vfree(buf);
+			return -EINVAL;
+		}
+	}
+
+	spin_lock_irqsave(&plat_data->wave_lock, flags);
+	stale[0] = plat_data->wave_old;
+	plat_data->wave_old = NULL;
+
+	if (plat_data->wave_next) {
+		err = -EBUSY;
+	} else if (plat_data->wave_stats.running) {
+		plat_data->wave_next = buf;
+		plat_data->wave_stats.queued = 1;
+	} else {
+		stale[1] = plat_data->wave_cur;
+		plat_data->wave_cur = buf;
+		plat_data->wave_pos = 0;
+		plat_data->wave_stats.running = 1;
+		start = true;
+	}
+	spin_unlock_irqrestore(&plat_data->wave_lock, flags);
+
+	if (start)
+		hrtimer_start(&plat_data->htimer, ktime_set(0, 0),
+			      HRTIMER_MODE_REL);
+
+	vfree(stale[0]);
+	vfree(stale[1]);
+	if (err)
+		vfree(buf);
+
+	return err;
+}
+
+static void misc_gpio_wave_stop(struct driver_data *plat_data)
+{
+	struct misc_gpio_wave_buf *stale[3];
+	unsigned long flags;
+
+	hrtimer_cancel(&plat_data->htimer);
+
+	spin_lock_irqsave(&plat_data->wave_lock, flags);
+	stale[0] = plat_data->wave_cur;
+	stale[1] = plat_data->wave_next;
+	stale[2] = plat_data->wave_old;
+	plat_data->wave_cur = NULL;
+	plat_data->wave_next = NULL;
+	plat_data->wave_old = NULL;
+	plat_data->wave_stats.running = 0;
+	plat_data->wave_stats.queued = 0;
+	spin_unlock_irqrestore(&plat_data->wave_lock, flags);
+
+	vfree(stale[0]);
+	vfree(stale[1]);
+	vfree(stale[2]);
+}
+
+static int misc_gpio_wave_get_stats(struct driver_data *plat_data,
+				    struct gpio_misc_wave_stats __user *argp)
+{
+	struct gpio_misc_wave_stats stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&plat_data->wave_lock, flags);
+	stats = plat_data->wave_stats;
+	spin_unlock_irqrestore(&plat_data->wave_lock, flags);
+
+	return copy_to_user(argp, &stats, sizeof(stats)) ? -EFAULT : 0;
+}
+
+static int misc_gpio_sampler_start(struct driver_data *plat_data,
+				   const struct gpio_misc_sampler __user *argp)
+{
+	struct gpio_misc_sampler req;
+	int err = 0;
+
+	if (copy_from_user(&req, argp, sizeof(req)))
+		return -EFAULT;
+
+	if (req.rate_hz < GPIO_MISC_SAMPLER_MIN_HZ ||
+	    req.rate_hz > GPIO_MISC_SAMPLER_MAX_HZ)
+		return -EINVAL;
+
+	mutex_lock(&plat_data->sample_lock);
+
+	if (plat_data->sampling) {
+		err = -EBUSY;
+		goto out;
+	}
+
+	if (!plat_data->runs) {
+		plat_data->runs = vmalloc(GPIO_MISC_SAMPLER_RUNS *
+					  sizeof(*plat_data->runs));
+		if (!plat_data->runs) {
+			err = -ENOMEM;
+			goto out;
+		}
+	}
+
+	plat_data->run_head = 0;
+	plat_data->sample_missed = 0;
+	plat_data->sample_mask = req.mask ? req.mask : U32_MAX;
+	plat_data->sample_rate = req.rate_hz;
+	plat_data->sample_period_ns = div_u64(NSEC_PER_SEC, req.rate_hz);
+	plat_data->sampling = true;
+
+	hrtimer_start(&plat_data->stimer, ktime_set(0, 0), HRTIMER_MODE_REL);
+out:
+	mutex_unlock(&plat_data->sample_lock);
+	return err;
+}
+
+static void misc_gpio_sampler_stop(struct driver_data *plat_data)
+{
+	mutex_lock(&plat_data->sample_lock);
+	hrtimer_cancel(&plat_data->stimer);
+	plat_data->sampling = false;
+	mutex_unlock(&plat_data->sample_lock);
+}
+
+static int misc_gpio_set_filter(struct misc_gpio_client *client,
+				void __user *argp)
+{
+	struct gpio_misc_filter filter;
+
+	if (copy_from_user(&filter, argp, sizeof(filter)))
+		return -EFAULT;
+
+	if (filter.reserved ||
+	    (filter.edges & ~(GPIO_MISC_EDGE_MASK(GPIO_MISC_EDGE_FALLING) |
+			      GPIO_MISC_EDGE_MASK(GPIO_MISC_EDGE_RISING))))
+		return -EINVAL;
+
+	/* applies from the next edge, the queued events stay */
+	WRITE_ONCE(client->pin_filter, filter.pins);
+	WRITE_ONCE(client->edge_filter, filter.edges);
+
+	filter.lost = READ_ONCE(client->lost);
+	if (copy_to_user(argp, &filter, sizeof(filter)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int misc_gpio_set_wake(struct driver_data *plat_data,
+			      void __user *argp)
+{
+	struct gpio_misc_wake wake;
+
+	if (copy_from_user(&wake, argp, sizeof(wake)))
+		return -EFAULT;
+
+	if (wake.pins & ~plat_data->pin_mask)
+		return -EINVAL;
+
+	/* applies from the next suspend */
+	mutex_lock(&plat_data->wake_lock);
+	plat_data->wake_mask = wake.pins;
+	plat_data->wake_holdoff_ns = (u64)wake.holdoff_ms * NSEC_PER_MSEC;
+	wake.wakes = plat_data->wake_seq;
+	wake.held_off = plat_data->wake_held_off;
+	mutex_unlock(&plat_data->wake_lock);
+
+	if (copy_to_user(argp, &wake, sizeof(wake)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int misc_gpio_wake_events(struct driver_data *plat_data,
+				 void __user *argp)
+{
+	struct gpio_misc_wake_event __user *uev;
+	struct gpio_misc_wake_log log;
+	u32 n = 0;
+	int err = 0;
+
+	if (copy_from_user(&log, argp, sizeof(log)))
+		return -EFAULT;
+
+	uev = (void __user *)(uintptr_t)log.events;
+
+	mutex_lock(&plat_data->wake_lock);
+	while (n < log.count && plat_data->wake_tail != plat_data->wake_head) {
+		if (copy_to_user(&uev[n], &plat_data->wake_events[
+				 plat_data->wake_tail % GPIO_MISC_WAKE_EVENTS],
+				 sizeof(*uev))) {
+			err = -EFAULT;
+			break;
+		}
+		plat_data->wake_tail++;
+		n++;
+	}
+	log.lost = plat_data->wake_lost;
+	plat_data->wake_lost = 0;
+	mutex_unlock(&plat_data->wake_lock);
+
+	if (err)
+		return err;
+
+	log.count = n;
+	if (copy_to_user(argp, &log, sizeof(log)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static long misc_gpio_do_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	struct driver_data *plat_data = to_driver_data(file);
+	struct nx_alive_gpio_regs __iomem *regs = plat_data->palive_gpio;
+	void __user *argp = (void __user *)arg;
+	struct gpio_misc_line_values lv;
+
+	switch (cmd) {
+	case GPIO_MISC_IOC_GET_VERSION:
+		return put_user(GPIO_MISC_ABI_VERSION, (u32 __user *)argp);
+	case GPIO_MISC_IOC_WAVE_SUBMIT:
+		return misc_gpio_wave_submit(plat_data, argp);
+	case GPIO_MISC_IOC_WAVE_STOP:
+		misc_gpio_wave_stop(plat_data);
+		return 0;
+	case GPIO_MISC_IOC_WAVE_STATS:
+		return misc_gpio_wave_get_stats(plat_data, argp);
+	case GPIO_MISC_IOC_CAPTURE:
+		return misc_gpio_capture_ioctl(plat_data, argp);
+	case GPIO_MISC_IOC_CAPTURE_RESET:
+		if (get_user(lv.mask, (u32 __user *)argp))
+			return -EFAULT;
+		misc_gpio_capture_reset(plat_data, lv.mask);
+		return 0;
+	case GPIO_MISC_IOC_SAMPLER_START:
+		return misc_gpio_sampler_start(plat_data, argp);
+	case GPIO_MISC_IOC_SAMPLER_STOP:
+		misc_gpio_sampler_stop(plat_data);
+		return 0;
+	case GPIO_MISC_IOC_SET_FILTER:
+		return misc_gpio_set_filter(file->private_data, argp);
+	case GPIO_MISC_IOC_SET_WAKE:
+		return misc_gpio_set_wake(plat_data, argp);
+	case GPIO_MISC_IOC_WAKE_EVENTS:
+		return misc_gpio_wake_events(plat_data, argp);
+	case GPIO_MISC_IOC_SET_VALUES:
+	case GPIO_MISC_IOC_GET_VALUES:
+	case GPIO_MISC_IOC_SET_DIRECTION:
+	case GPIO_MISC_IOC_GET_DIRECTION:
+		break;
+	default:
+		return -ENOTTY;
+	}
+
+	if (copy_from_user(&lv, argp, sizeof(lv)))
+		return -EFAULT;
+
+	if (lv.padding[0] || lv.padding[1] || (lv.mask & ~plat_data->pin_mask))
+		return -EINVAL;
+
+	switch (cmd) {
+	case GPIO_MISC_IOC_SET_VALUES:
+		alive_gpio_set_values(regs, lv.mask, lv.bits);
+		return 0;
+	case GPIO_MISC_IOC_SET_DIRECTION:
+		alive_gpio_set_directions(regs, lv.mask, lv.bits);
+		return 0;
+	case GPIO_MISC_IOC_GET_VALUES:
+		lv.bits = alive_gpio_get_values(regs, lv.mask);
+		break;
+	case GPIO_MISC_IOC_GET_DIRECTION:
+		lv.bits = alive_gpio_get_directions(regs, lv.mask);
+		break;
+	}
+
+	if (copy_to_user(argp, &lv, sizeof(lv)))
+		return -EFAULT;
+
+	return 0;
+}
+
+/* the wave and sampler start paths are all behind the dead check */
+static long misc_gpio_ioctl(struct file *file, unsigned int cmd,
+			   unsigned long arg)
+{
+	struct driver_data *plat_data = to_driver_data(file);
+	long ret;
+
+	down_read(&plat_data->dead_lock);
+	ret = plat_data->dead ? -ENODEV : misc_gpio_do_ioctl(file, cmd, arg);
+	up_read(&plat_data->dead_lock);
+
+	return ret;
+}
+
+/* PWM edge queue, callers hold pwm_lock; returns whether ch was queued */
+static bool misc_gpio_pwm_dequeue(struct driver_data *plat_data, int ch)
+{
+	unsigned int i;
+
+	for (i = 0; i < plat_data->pwm_nqueued; i++) {
+		if (plat_data->pwm_queue[i] != ch)
+			continue;
+		memmove(&plat_data->pwm_queue[i], &plat_data->pwm_queue[i + 1],
+			plat_data->pwm_nqueued - i - 1);
+		plat_data->pwm_nqueued--;
+		return true;
+	}
+	return false;
+}
+
+/* insert by next_ns, behind the channels due at the same time */
+static void misc_gpio_pwm_enqueue(struct driver_data *plat_data, int ch)
+{
+	u64 next = plat_data->pwm[ch].next_ns;
+	unsigned int i = plat_data->pwm_nqueued;
+
+	while (i && plat_data->pwm[plat_data->pwm_queue[i - 1]].next_ns > next) {
+		plat_data->pwm_queue[i] = plat_data->pwm_queue[i - 1];
+		i--;
+	}
+	plat_data->pwm_queue[i] = ch;
+	plat_data->pwm_nqueued++;
+}
+
+static inline struct driver_data *pwm_to_driver_data(struct pwm_chip *chip)
+{
+	return container_of(chip, struct driver_data, pwm_chip);
+}
+
+/*
+ * Applies the enable state and settings of a channel, caller holds
+ * pwm_lock. A toggling channel that is already queued keeps its phase
+ * and picks the new settings up on its next edge.
+ */
+static void misc_gpio_pwm_update(struct driver_data *plat_data, int ch)
+{
+	struct misc_gpio_pwm *pwm = &plat_data->pwm[ch];
+	u32 bit = BIT(plat_data->pins[ch].id);
+	bool queued = misc_gpio_pwm_dequeue(plat_data, ch);
+
+	if (pwm->enabled && pwm->duty_ns && pwm->duty_ns < pwm->period_ns) {
+		if (!queued) {
+			pwm->start_ns = ktime_get_ns();
+			pwm->next_ns = pwm->start_ns;
+			pwm->rising = true;
+		}
+		misc_gpio_pwm_enqueue(plat_data, ch);
+	} else {
+		alive_gpio_set_values(plat_data->palive_gpio, bit,
+				      pwm->enabled && pwm->duty_ns ? bit : 0);
+	}
+
+	if (plat_data->pwm_nqueued)
+		hrtimer_start(&plat_data->pwm_timer,
+			ns_to_ktime(plat_data->pwm[plat_data->pwm_queue[0]].next_ns),
+			HRTIMER_MODE_ABS);
+	else
+		hrtimer_try_to_cancel(&plat_data->pwm_timer);
+}
+
+static irqreturn_t gpio_irq_handler(int irq, void *dev_id);
+static irqreturn_t gpio_interrupt_thread_fn(int irq, void *dev_id);
+
+/* edge IRQ of a DT input pin, both edges into the event path */
+static int misc_gpio_request_pin_irq(struct misc_gpio_pin *pin)
+{
+	int err;
+
+	pin->irq = gpio_to_irq(ALIVE_BASE + pin->id);
+	err = request_threaded_irq(pin->irq,
+		gpio_irq_handler,
+		gpio_interrupt_thread_fn,
+		IRQF_TRIGGER_RISING |
+		IRQF_TRIGGER_FALLING,
+		pin->plat_data->name, pin);
+	if (err) {
+		pr_err("my_device: cannot register IRQ %d\n", pin->irq);
+		pin->irq = 0;
+	}
+	return err;
+}
+
+/*
+ * A PWM channel takes its DT pin over from the input side: the pin's
+ * edge IRQ is released while the channel is requested, so PWM edges do
+ * not run the event, ring and capture paths, and requested again on
+ * free. Slots owned by configfs have their own PWM mode and are busy.
+ */
+static int misc_gpio_pwm_request(struct pwm_chip *chip, struct pwm_device *pwm)
+{
+	struct driver_data *plat_data = pwm_to_driver_data(chip);
+	struct misc_gpio_pin *pin = &plat_data->pins[pwm->hwpwm];
+	u32 bit = BIT(pin->id);
+	int err = 0;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	if (plat_data->dead) {
+		err = -ENODEV;
+		goto out;
+	}
+	if (!pin->plat_data || pin->cfs) {
+		err = -EBUSY;
+		goto out;
+	}
+
+	if (pin->irq > 0)
+		free_irq(pin->irq, pin);
+	pin->irq = 0;
+	pin->mode = GPIO_MISC_MODE_PWM;
+
+	alive_gpio_set_values(plat_data->palive_gpio, bit, 0);
+	alive_gpio_set_directions(plat_data->palive_gpio, bit, bit);
+out:
+	mutex_unlock(&misc_gpio_devices_lock);
+	return err;
+}
+
+/*
+ * pwm_put() and sysfs unexport do not disable the channel first, take it
+ * off the edge queue here. If the edge IRQ cannot be had back the pin
+ * stays a PWM slot, driven low, which is the mode that has no IRQ.
+ */
+static void misc_gpio_pwm_free(struct pwm_chip *chip, struct pwm_device *pwm)
+{
+	struct driver_data *plat_data = pwm_to_driver_data(chip);
+	struct misc_gpio_pin *pin = &plat_data->pins[pwm->hwpwm];
+	struct misc_gpio_pwm *ch = &plat_data->pwm[pwm->hwpwm];
+	unsigned long flags;
+	int err;
+
+	spin_lock_irqsave(&plat_data->pwm_lock, flags);
+	ch->enabled = false;
+	ch->duty_ns = 0;
+	ch->period_ns = 0;
+	if (!READ_ONCE(plat_data->dead))
+		misc_gpio_pwm_update(plat_data, pwm->hwpwm);
+	spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+
+	/* after remove the pins and their IRQs are no longer ours */
+	mutex_lock(&misc_gpio_devices_lock);
+	if (plat_data->dead) {
+		mutex_unlock(&misc_gpio_devices_lock);
+		return;
+	}
+	err = misc_gpio_request_pin_irq(pin);
+	if (err) {
+		dev_warn(plat_data->dev, "pin %u stays in pwm mode, no irq (%d)\n",
+			 pin->id, err);
+	} else {
+		alive_gpio_set_directions(plat_data->palive_gpio,
+					  BIT(pin->id), 0);
+		pin->mode = GPIO_MISC_MODE_INPUT;
+	}
+	mutex_unlock(&misc_gpio_devices_lock);
+}
+
+static int misc_gpio_pwm_config(struct pwm_chip *chip, struct pwm_device *pwm,
+				int duty_ns, int period_ns)
+{
+	struct driver_data *plat_data = pwm_to_driver_data(chip);
+	unsigned long flags;
+
+	if (period_ns < GPIO_MISC_PWM_MIN_PERIOD_NS)
+		return -EINVAL;
+
+	spin_lock_irqsave(&plat_data->pwm_lock, flags);
+	if (READ_ONCE(plat_data->dead)) {
+		spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+		return -ENODEV;
+	}
+	plat_data->pwm[pwm->hwpwm].duty_ns = duty_ns;
+	plat_data->pwm[pwm->hwpwm].period_ns = period_ns;
+	misc_gpio_pwm_update(plat_data, pwm->hwpwm);
+	spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+
+	return 0;
+}
+
+static int misc_gpio_pwm_set_enabled(struct driver_data *plat_data, int ch,
+				     bool enabled)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&plat_data->pwm_lock, flags);
+	if (enabled && READ_ONCE(plat_data->dead)) {
+		spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+		return -ENODEV;
+	}
+	plat_data->pwm[ch].enabled = enabled;
+	misc_gpio_pwm_update(plat_data, ch);
+	spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+
+	return 0;
+}
+
+/*
+ * Stops every channel for remove, pins keep their level. Called once
+ * dead is set, the ops above cannot queue a channel again.
+ */
+static void misc_gpio_pwm_stop(struct driver_data *plat_data)
+{
+	unsigned long flags;
+	int ch;
+
+	spin_lock_irqsave(&plat_data->pwm_lock, flags);
+	for (ch = 0; ch < ARRAY_SIZE(plat_data->pwm); ch++)
+		plat_data->pwm[ch].enabled = false;
+	plat_data->pwm_nqueued = 0;
+	spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+
+	hrtimer_cancel(&plat_data->pwm_timer);
+}
+
+static int misc_gpio_pwm_enable(struct pwm_chip *chip, struct pwm_device *pwm)
+{
+	return misc_gpio_pwm_set_enabled(pwm_to_driver_data(chip),
+					 pwm->hwpwm, true);
+}
+
+static void misc_gpio_pwm_disable(struct pwm_chip *chip, struct pwm_device *pwm)
+{
+	misc_gpio_pwm_set_enabled(pwm_to_driver_data(chip), pwm->hwpwm, false);
+}
+
+static const struct pwm_ops misc_gpio_pwm_ops = {
+	.request = misc_gpio_pwm_request,
+	.free    = misc_gpio_pwm_free,
+	.config  = misc_gpio_pwm_config,
+	.enable  = misc_gpio_pwm_enable,
+	.disable = misc_gpio_pwm_disable,
+	.owner   = THIS_MODULE,
+};
+
+/* sysfs, one capture line per pin, any write resets the counters */
+static ssize_t capture_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct miscdevice *mdev = dev_get_drvdata(dev);
+	struct driver_data *plat_data =
+		container_of(mdev, struct driver_data, mdev);
+	struct gpio_misc_capture cap;
+	ssize_t len = 0;
+	int i;
+
+	for (i = 0; i < plat_data->npins; i++) {
+		if (!plat_data->pins[i].plat_data)
+			continue;
+		misc_gpio_capture_get(&plat_data->pins[i], &cap);
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+			"pin %u: edges %llu period %llu high %llu min %llu max %llu avg %llu duty %u.%u%%\n",
+			cap.pin, cap.edges, cap.period_ns, cap.high_ns,
+			cap.width_min_ns, cap.width_max_ns, cap.width_avg_ns,
+			cap.duty_permille / 10, cap.duty_permille % 10);
+	}
+
+	return len;
+}
+
+static ssize_t capture_store(struct device *dev, struct device_attribute *attr,
+			     const char *buf, size_t count)
+{
+	struct miscdevice *mdev = dev_get_drvdata(dev);
+	struct driver_data *plat_data =
+		container_of(mdev, struct driver_data, mdev);
+
+	misc_gpio_capture_reset(plat_data, plat_data->pin_mask);
+	return count;
+}
+static DEVICE_ATTR_RW(capture);
+
+static struct attribute *misc_gpio_attrs[] = {
+	&dev_attr_capture.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(misc_gpio);
+
+/* debugfs readout of the pad sampler, only while it is stopped */
+static ssize_t sampler_raw_read(struct file *file, char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct driver_data *plat_data = file->private_data;
+	const u32 esize = sizeof(struct gpio_misc_sample_run);
+	u32 first, nruns, idx, off;
+	size_t done = 0, chunk;
+	ssize_t ret;
+
+	mutex_lock(&plat_data->sample_lock);
+
+	if (plat_data->sampling) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	nruns = min_t(u32, plat_data->run_head, GPIO_MISC_SAMPLER_RUNS);
+	first = plat_data->run_head - nruns;
+
+	while (done < count && *ppos < (loff_t)nruns * esize) {
+		idx = (first + div_u64_rem(*ppos, esize, &off)) &
+		      (GPIO_MISC_SAMPLER_RUNS - 1);
+		chunk = min_t(size_t, esize - off, count - done);
+
+		if (copy_to_user(buf + done, (char *)&plat_data->runs[idx] + off,
+				 chunk)) {
+			ret = -EFAULT;
+			goto out;
+		}
+		done += chunk;
+		*ppos += chunk;
+	}
+	ret = done;
+out:
+	mutex_unlock(&plat_data->sample_lock);
+	return ret;
+}
+
+static const struct file_operations sampler_raw_fops = {
+	.owner  = THIS_MODULE,
+	.open   = simple_open,
+	.read   = sampler_raw_read,
+	.llseek = default_llseek,
+};
+
+/* format the runs as VCD, with buf NULL only the length is computed */
+static size_t misc_gpio_vcd_format(struct driver_data *plat_data,
+				   char *buf, size_t size)
+{
+	u32 nruns = min_t(u32, plat_data->run_head, GPIO_MISC_SAMPLER_RUNS);
+	u32 first = plat_data->run_head - nruns;
+	u32 mask = plat_data->sample_mask;
+	u32 prev = 0, changed, i;
+	u64 t = 0;
+	size_t len = 0;
+	int bit;
+
+#define VCD_OUT(...) \
+	(len += snprintf(buf ? buf + len : NULL, buf ? size - len : 0, __VA_ARGS__))
+
+	VCD_OUT("$timescale 1 ns $end\n$scope module %s $end\n",
+		plat_data->name);
+	for (bit = 0; bit < 32; bit++)
+		if (mask & BIT(bit))
+			VCD_OUT("$var wire 1 %c pin%d $end\n", '!' + bit, bit);
+	VCD_OUT("$upscope $end\n$enddefinitions $end\n");
+
+	for (i = 0; i < nruns; i++) {
+		const struct gpio_misc_sample_run *run =
+			&plat_data->runs[(first + i) & (GPIO_MISC_SAMPLER_RUNS - 1)];
+
+		changed = i ? (run->value ^ prev) : mask;
+		VCD_OUT("#%llu\n", t);
+		for (bit = 0; bit < 32; bit++)
+			if (changed & BIT(bit))
+				VCD_OUT("%u%c\n", (run->value >> bit) & 1, '!' + bit);
+
+		prev = run->value;
+		t += (u64)run->count * plat_data->sample_period_ns;
+	}
+	VCD_OUT("#%llu\n", t);
+
+#undef VCD_OUT
+	return len;
+}
+
+/* the VCD text is rendered once per open() */
+struct misc_gpio_vcd {
+	size_t len;
+	char text[];
+};
+
+static int sampler_vcd_open(struct inode *inode, struct file *file)
+{
+	struct driver_data *plat_data = inode->i_private;
+	struct misc_gpio_vcd *vcd;
+	size_t len;
+	int err = 0;
+
+	mutex_lock(&plat_data->sample_lock);
+
+	if (plat_data->sampling) {
+		err = -EBUSY;
+		goto out;
+	}
+	if (!plat_data->runs) {
+		err = -ENODATA;
+		goto out;
+	}
+
+	len = misc_gpio_vcd_format(plat_data, NULL, 0);
+	vcd = vmalloc(sizeof(*vcd) + len + 1);
+	if (!vcd) {
+		err = -ENOMEM;
+		goto out;
+	}
+	vcd->len = misc_gpio_vcd_format(plat_data, vcd->text, len + 1);
+	file->private_data = vcd;
+out:
+	mutex_unlock(&plat_data->sample_lock);
+	return err;
+}
+
+static ssize_t sampler_vcd_read(struct file *file, char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct misc_gpio_vcd *vcd = file->private_data;
+
+	return simple_read_from_buffer(buf, count, ppos, vcd->text, vcd->len);
+}
+
+static int sampler_vcd_release(struct inode *inode, struct file *file)
+{
+	vfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations sampler_vcd_fops = {
+	.owner   = THIS_MODULE,
+	.open    = sampler_vcd_open,
+	.read    = sampler_vcd_read,
+	.release = sampler_vcd_release,
+	.llseek  = default_llseek,
+};
+
+static const char * const misc_gpio_lat_names[GPIO_MISC_LAT_KINDS] = {
+	[GPIO_MISC_LAT_TOP]   = "top_half",
+	[GPIO_MISC_LAT_WAKE]  = "thread_wake",
+	[GPIO_MISC_LAT_TOTAL] = "total",
+};
+
+/* debugfs histograms, summed over all CPUs */
+static int latency_show(struct seq_file *m, void *unused)
+{
+	struct driver_data *plat_data = m->private;
+	u32 hist[GPIO_MISC_LAT_KINDS][GPIO_MISC_LAT_BUCKETS] = { };
+	u64 max_ns[GPIO_MISC_LAT_KINDS] = { };
+	u64 count[GPIO_MISC_LAT_KINDS] = { };
+	int cpu, k, b;
+
+	for_each_possible_cpu(cpu) {
+		const struct misc_gpio_lat *lat = per_cpu_ptr(plat_data->lat, cpu);
+
+		for (k = 0; k < GPIO_MISC_LAT_KINDS; k++) {
+			for (b = 0; b < GPIO_MISC_LAT_BUCKETS; b++) {
+				hist[k][b] += lat->hist[k][b];
+				count[k] += lat->hist[k][b];
+			}
+			max_ns[k] = max(max_ns[k], lat->max_ns[k]);
+		}
+	}
+
+	seq_printf(m, "%-12s", "ns>=");
+	for (k = 0; k < GPIO_MISC_LAT_KINDS; k++)
+		seq_printf(m, " %12s", misc_gpio_lat_names[k]);
+	seq_putc(m, '\n');
+
+	for (b = 0; b < GPIO_MISC_LAT_BUCKETS; b++) {
+		if (!hist[GPIO_MISC_LAT_TOP][b] && !hist[GPIO_MISC_LAT_WAKE][b] &&
+		    !hist[GPIO_MISC_LAT_TOTAL][b])
+			continue;
+		seq_printf(m, "%-12llu", b ? 1ULL << (b - 1) : 0ULL);
+		for (k = 0; k < GPIO_MISC_LAT_KINDS; k++)
+			seq_printf(m, " %12u", hist[k][b]);
+		seq_putc(m, '\n');
+	}
+
+	seq_printf(m, "%-12s", "count");
+	for (k = 0; k < GPIO_MISC_LAT_KINDS; k++)
+		seq_printf(m, " %12llu", count[k]);
+	seq_printf(m, "\n%-12s", "max");
+	for (k = 0; k < GPIO_MISC_LAT_KINDS; k++)
+		seq_printf(m, " %12llu", max_ns[k]);
+	seq_putc(m, '\n');
+
+	return 0;
+}
+
+static int latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, latency_show, inode->i_private);
+}
+
+static const struct file_operations latency_fops = {
+	.owner   = THIS_MODULE,
+	.open    = latency_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+/* any write clears the histograms, racing updates may survive */
+static ssize_t latency_reset_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	struct driver_data *plat_data = file->private_data;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(plat_data->lat, cpu), 0,
+		       sizeof(struct misc_gpio_lat));
+
+	return count;
+}
+
+static const struct file_operations latency_reset_fops = {
+	.owner  = THIS_MODULE,
+	.open   = simple_open,
+	.write  = latency_reset_write,
+	.llseek = default_llseek,
+};
+
+/* file operation structure */
+static const struct file_operations misc_fops = {
+	.write          = misc_gpio_write,
+	.read           = misc_gpio_read,
+	.open           = misc_gpio_open,
+	.unlocked_ioctl = misc_gpio_ioctl,
+	.poll           = misc_gpio_poll,
+	.mmap           = misc_gpio_mmap,
+	.fasync         = misc_gpio_fasync,
+	.release        = misc_gpio_close,
+};
+
+/* interrupt functions */
+/* waveform engine, plays one step per expiry */
+static enum hrtimer_restart timer_callback(struct hrtimer *timer)
+{
+	struct driver_data *plat_data =
+		container_of(timer, struct driver_data, htimer);
+	struct gpio_misc_wave_stats *stats = &plat_data->wave_stats;
+	const struct gpio_misc_wave_step *step;
+	struct misc_gpio_wave_buf *buf;
+	ktime_t now = hrtimer_cb_get_time(timer);
+	s64 late;
+
+	spin_lock(&plat_data->wave_lock);
+
+	buf = plat_data->wave_cur;
+	if (!buf || !stats->running) {
+		stats->running = 0;
+		spin_unlock(&plat_data->wave_lock);
+		return HRTIMER_NORESTART;
+	}
+
+	late = ktime_to_ns(ktime_sub(now, hrtimer_get_expires(timer)));
+	if (late > 0) {
+		stats->overshoot_total_ns += late;
+		if (late > stats->overshoot_max_ns)
+			stats->overshoot_max_ns = late;
+	}
+
+	step = &buf->steps[plat_data->wave_pos];
+	alive_gpio_set_values(plat_data->palive_gpio, step->mask, step->value);
+	stats->steps++;
+
+	/* keep the step grid, unless we fell behind it */
+	hrtimer_add_expires_ns(timer, step->duration_ns);
+	if (ktime_to_ns(ktime_sub(hrtimer_get_expires(timer), now)) < 0)
+		hrtimer_set_expires(timer, now);
+
+	if (++plat_data->wave_pos < buf->nsteps)
+		goto out;
+
+	stats->buffers++;
+	plat_data->wave_pos = 0;
+
+	if (plat_data->wave_next) {
+		/* the submitter freed wave_old before queueing wave_next */
+		plat_data->wave_old = buf;
+		plat_data->wave_cur = plat_data->wave_next;
+		plat_data->wave_next = NULL;
+		stats->queued = 0;
+	} else if (!(buf->flags & GPIO_MISC_WAVE_LOOP)) {
+		if (!(buf->flags & GPIO_MISC_WAVE_LAST))
+			stats->underruns++;
+		stats->running = 0;
+		spin_unlock(&plat_data->wave_lock);
+		return HRTIMER_NORESTART;
+	}
+
+out:
+	spin_unlock(&plat_data->wave_lock);
+	return HRTIMER_RESTART;
+}
+
+/* single producer side of the mmap() ring, runs in the top half */
+static bool misc_gpio_ring_put(struct driver_data *plat_data,
+			       const struct gpio_misc_event *ev)
+{
+	struct gpio_misc_ring_header *ring = plat_data->ring;
+	u32 head = plat_data->ring_head;
+
+	/* tail is written by user space, only trust it for the room check */
+	if (head - smp_load_acquire(&ring->tail) >= GPIO_MISC_RING_RECORDS) {
+		ring->overflow++;
+		return false;
+	}
+
+	plat_data->ring_records[head & (GPIO_MISC_RING_RECORDS - 1)] = *ev;
+	plat_data->ring_head = head + 1;
+	smp_store_release(&ring->head, head + 1);
+
+	return true;
+}
+
+/*
+ * Plays every edge due within the slack, collecting them into one set
+ * and one reset mask, then sleeps until the next queued edge.
+ */
+static enum hrtimer_restart pwm_timer_callback(struct hrtimer *timer)
+{
+	struct driver_data *plat_data =
+		container_of(timer, struct driver_data, pwm_timer);
+	u64 now = ktime_to_ns(hrtimer_cb_get_time(timer));
+	struct misc_gpio_pwm *pwm;
+	u32 set = 0, reset = 0, bit;
+	u64 behind;
+	int ch;
+
+	spin_lock(&plat_data->pwm_lock);
+
+	/* restarted by a channel update while we waited for the lock */
+	if (hrtimer_is_queued(timer)) {
+		spin_unlock(&plat_data->pwm_lock);
+		return HRTIMER_NORESTART;
+	}
+
+	plat_data->pwm_ticks++;
+
+	while (plat_data->pwm_nqueued) {
+		ch = plat_data->pwm_queue[0];
+		pwm = &plat_data->pwm[ch];
+		if (pwm->next_ns > now + GPIO_MISC_PWM_SLACK_NS)
+			break;
+
+		misc_gpio_pwm_dequeue(plat_data, ch);
+		bit = BIT(plat_data->pins[ch].id);
+
+		/* period and duty updates take effect on the next edge */
+		if (pwm->rising) {
+			set |= bit;
+			reset &= ~bit;
+			pwm->next_ns = pwm->start_ns + pwm->duty_ns;
+		} else {
+			reset |= bit;
+			set &= ~bit;
+			pwm->start_ns += pwm->period_ns;
+			if (pwm->start_ns + pwm->period_ns <= now) {
+				behind = div64_u64(now - pwm->start_ns,
+						   pwm->period_ns);
+				pwm->start_ns += behind * pwm->period_ns;
+				plat_data->pwm_missed += behind;
+			}
+			pwm->next_ns = pwm->start_ns;
+		}
+		pwm->rising = !pwm->rising;
+		misc_gpio_pwm_enqueue(plat_data, ch);
+	}
+
+	if (set | reset) {
+		alive_gpio_set_values(plat_data->palive_gpio, set | reset, set);
+		plat_data->pwm_writes++;
+	}
+
+	if (!plat_data->pwm_nqueued) {
+		spin_unlock(&plat_data->pwm_lock);
+		return HRTIMER_NORESTART;
+	}
+
+	hrtimer_set_expires(timer,
+		ns_to_ktime(plat_data->pwm[plat_data->pwm_queue[0]].next_ns));
+	spin_unlock(&plat_data->pwm_lock);
+	return HRTIMER_RESTART;
+}
+
+/* pad sampler, extends the current run or starts a new one */
+static enum hrtimer_restart sampler_callback(struct hrtimer *timer)
+{
+	struct driver_data *plat_data =
+		container_of(timer, struct driver_data, stimer);
+	struct gpio_misc_sample_run *run;
+	u64 missed, n;
+	u32 value, held;
+
+	/* periods the timer overran are taken as holding the last value */
+	missed = hrtimer_forward_now(timer,
+			ns_to_ktime(plat_data->sample_period_ns)) - 1;
+	value = ioread32(&plat_data->palive_gpio->pad) & plat_data->sample_mask;
+
+	run = &plat_data->runs[(plat_data->run_head - 1) &
+			       (GPIO_MISC_SAMPLER_RUNS - 1)];
+	if (plat_data->run_head) {
+		plat_data->sample_missed += missed;
+
+		/* a long stall saturates the run and continues in new ones */
+		while (missed) {
+			n = min_t(u64, missed, U32_MAX - run->count);
+			run->count += n;
+			missed -= n;
+			if (!missed)
+				break;
+			held = run->value;
+			run = &plat_data->runs[plat_data->run_head++ &
+					       (GPIO_MISC_SAMPLER_RUNS - 1)];
+			run->value = held;
+			run->count = 0;
+		}
+	}
+
+	if (plat_data->run_head && run->value == value &&
+	    run->count != U32_MAX) {
+		run->count++;
+	} else {
+		run = &plat_data->runs[plat_data->run_head++ &
+				       (GPIO_MISC_SAMPLER_RUNS - 1)];
+		run->value = value;
+		run->count = 1;
+	}
+
+	return HRTIMER_RESTART;
+}
+
+/* pulse statistics from consecutive edges, caller holds event_lock */
+static void misc_gpio_capture_edge(struct misc_gpio_pin *pin, u64 now,
+				   bool rising)
+{
+	u64 width;
+
+	pin->edges++;
+
+	if (rising) {
+		if (pin->rise_ns)
+			pin->period_ns = now - pin->rise_ns;
+		pin->rise_ns = now;
+		return;
+	}
+
+	if (pin->rise_ns > pin->fall_ns) {
+		width = now - pin->rise_ns;
+		pin->high_ns = width;
+		if (!pin->widths || width < pin->width_min_ns)
+			pin->width_min_ns = width;
+		if (width > pin->width_max_ns)
+			pin->width_max_ns = width;
+		pin->width_sum_ns += width;
+		pin->widths++;
+	}
+	pin->fall_ns = now;
+}
+
+/*
+ * Called from the top half and from the IRQ thread, the thread side must
+ * not be interrupted by a top half on the same cpu between load and store.
+ */
+static void misc_gpio_lat_add(struct driver_data *plat_data, int kind, u64 ns)
+{
+	struct misc_gpio_lat *lat;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	lat = this_cpu_ptr(plat_data->lat);
+	lat->hist[kind][min_t(int, fls64(ns), GPIO_MISC_LAT_BUCKETS - 1)]++;
+	if (ns > lat->max_ns[kind])
+		lat->max_ns[kind] = ns;
+	local_irq_restore(flags);
+}
+
+/* queue and signal ev on every open() whose filter takes it, from a top half */
+static void misc_gpio_fan_out(struct driver_data *plat_data,
+			      struct gpio_misc_event ev)
+{
+	struct misc_gpio_client *client;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(client, &plat_data->clients, node) {
+		if (!(READ_ONCE(client->pin_filter) & BIT(ev.pin)) ||
+		    !(READ_ONCE(client->edge_filter) & GPIO_MISC_EDGE_MASK(ev.edge)))
+			continue;
+
+		/* a full queue only costs its own reader events */
+		spin_lock(&client->ev_lock);
+		ev.overflow = min_t(u32, client->overflow, U16_MAX);
+		if (kfifo_put(&client->events, ev)) {
+			client->overflow = 0;
+		} else {
+			client->overflow++;
+			client->lost++;
+		}
+		spin_unlock(&client->ev_lock);
+
+		kill_fasync(&client->async_queue, SIGIO, POLL_IN);
+	}
+	rcu_read_unlock();
+}
+
+/* top half shared by every pin of a device, dev_id is the pin channel */
+static irqreturn_t gpio_irq_handler(int irq, void *dev_id)
+{
+	struct misc_gpio_pin *pin = dev_id;
+	struct driver_data *plat_data = pin->plat_data;
+	struct gpio_misc_event ev;
+	u64 now;
+
+	ev.timestamp_ns = ktime_get_ns();
+	ev.pin = pin->id;
+	ev.edge = alive_gpio_get_value(plat_data->palive_gpio, pin->id) ?
+		  GPIO_MISC_EDGE_RISING : GPIO_MISC_EDGE_FALLING;
+
+	spin_lock(&plat_data->event_lock);
+	misc_gpio_capture_edge(pin, ev.timestamp_ns,
+			       ev.edge == GPIO_MISC_EDGE_RISING);
+
+	if (pin->mode == GPIO_MISC_MODE_CAPTURE)
+		goto out;
+
+	ev.seq = plat_data->seq++;
+
+	if (atomic_read(&plat_data->ring_users)) {
+		smp_rmb();
+		ev.overflow = min_t(u32, plat_data->overflow, U16_MAX);
+		if (misc_gpio_ring_put(plat_data, &ev))
+			plat_data->overflow = 0;
+		else
+			plat_data->overflow++;
+	}
+	spin_unlock(&plat_data->event_lock);
+
+	misc_gpio_fan_out(plat_data, ev);
+
+	spin_lock(&plat_data->event_lock);
+out:
+	now = ktime_get_ns();
+	if (!pin->wake_ns) {
+		pin->irq_ns = ev.timestamp_ns;
+		pin->wake_ns = now;
+	}
+	spin_unlock(&plat_data->event_lock);
+
+	misc_gpio_lat_add(plat_data, GPIO_MISC_LAT_TOP, now - ev.timestamp_ns);
+
+	return IRQ_WAKE_THREAD;
+}
+
+static irqreturn_t gpio_interrupt_thread_fn(int irq, void *dev_id)
+{
+	struct misc_gpio_pin *pin = dev_id;
+	struct driver_data *plat_data = pin->plat_data;
+	u64 start = ktime_get_ns();
+	u64 irq_ns, wake_ns;
+
+	/* edges coalesced into one wakeup are timed from the first of them */
+	spin_lock_irq(&plat_data->event_lock);
+	irq_ns = pin->irq_ns;
+	wake_ns = pin->wake_ns;
+	pin->wake_ns = 0;
+	spin_unlock_irq(&plat_data->event_lock);
+
+	/* ring consumers only sleep in poll() once they drained the ring */
+	smp_mb();
+	if (waitqueue_active(&plat_data->wait))
+		wake_up_interruptible(&plat_data->wait);
+
+	if (wake_ns) {
+		misc_gpio_lat_add(plat_data, GPIO_MISC_LAT_WAKE, start - wake_ns);
+		misc_gpio_lat_add(plat_data, GPIO_MISC_LAT_TOTAL,
+				  ktime_get_ns() - irq_ns);
+	}
+	return IRQ_HANDLED;
+}
+
+
+/* register access benchmark */
+static u32 legacy_getbit(u32 phys, unsigned pin)
+{
+	void __iomem *pvaddr;
+	u32 value;
+
+	pvaddr = ioremap(phys, 32);
+	value = (ioread32(pvaddr) >> pin) & 1;
+	iounmap(pvaddr);
+
+	return value;
+}
+
+/* the read of the old read-modify-write, the write is the pin bit alone */
+static void legacy_setbit(u32 phys, unsigned pin)
+{
+	void __iomem *pvaddr;
+
+	pvaddr = ioremap(phys, 32);
+	ioread32(pvaddr);
+	iowrite32(1UL << pin, pvaddr);
+	iounmap(pvaddr);
+}
+
+/*
+ * Compare the old map-per-access helpers against the persistent mapping.
+ * The set side writes the pin's current output level back through the
+ * data SET or RESET register, so the latch never changes.
+ */
+static void misc_gpio_bench(struct driver_data *plat_data)
+{
+	struct nx_alive_gpio_regs __iomem *regs = plat_data->palive_gpio;
+	u32 pad = plat_data->addr + offsetof(struct nx_alive_gpio_regs, pad);
+	unsigned int pin = plat_data->pins[0].id;
+	bool high = misc_getbit(&regs->pad_read, pin);
+	u32 same = plat_data->addr + (high ?
+		offsetof(struct nx_alive_gpio_regs, data) :
+		offsetof(struct nx_alive_gpio_regs, pad_reset));
+	unsigned int i;
+	u64 t0, get_old, set_old, get_new, set_new;
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < bench_loops; i++)
+		legacy_getbit(pad, pin);
+	get_old = ktime_get_ns() - t0;
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < bench_loops; i++)
+		legacy_setbit(same, pin);
+	set_old = ktime_get_ns() - t0;
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < bench_loops; i++)
+		alive_gpio_get_value(regs, pin);
+	get_new = ktime_get_ns() - t0;
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < bench_loops; i++)
+		misc_setbit(high ? &regs->data : &regs->pad_reset, pin);
+	set_new = ktime_get_ns() - t0;
+
+	pr_info("%s: %u loops, get %llu -> %llu ns/op, set %llu -> %llu ns/op\n",
+		plat_data->name, bench_loops,
+		div_u64(get_old, bench_loops), div_u64(get_new, bench_loops),
+		div_u64(set_old, bench_loops), div_u64(set_new, bench_loops));
+}
+
+/* takes a reference on the bank at addr, mapping it on first use */
+static struct misc_gpio_bank *misc_gpio_bank_get(u32 addr)
+{
+	struct misc_gpio_bank *bank;
+
+	mutex_lock(&misc_gpio_banks_lock);
+	list_for_each_entry(bank, &misc_gpio_banks, node) {
+		if (bank->addr == addr) {
+			kref_get(&bank->ref);
+			goto out;
+		}
+	}
+
+	bank = kzalloc(sizeof(*bank), GFP_KERNEL);
+	if (!bank) {
+		bank = ERR_PTR(-ENOMEM);
+		goto out;
+	}
+
+	bank->regs = ioremap(addr, sizeof(struct nx_alive_gpio_regs));
+	if (!bank->regs) {
+		pr_err("ERROR : ioremap %08X failed!\n", addr);
+		kfree(bank);
+		bank = ERR_PTR(-ENOMEM);
+		goto out;
+	}
+
+	bank->addr = addr;
+	kref_init(&bank->ref);
+	spin_lock_init(&bank->lock);
+	list_add(&bank->node, &misc_gpio_banks);
+out:
+	mutex_unlock(&misc_gpio_banks_lock);
+	return bank;
+}
+
+/* called with misc_gpio_banks_lock held */
+static void misc_gpio_bank_release(struct kref *ref)
+{
+	struct misc_gpio_bank *bank =
+		container_of(ref, struct misc_gpio_bank, ref);
+
+	list_del(&bank->node);
+	iounmap(bank->regs);
+	kfree(bank);
+}
+
+static void misc_gpio_bank_put(struct misc_gpio_bank *bank)
+{
+	mutex_lock(&misc_gpio_banks_lock);
+	kref_put(&bank->ref, misc_gpio_bank_release);
+	mutex_unlock(&misc_gpio_banks_lock);
+}
+
+/* a pin belongs to one device node, even across nodes of the same bank */
+static int misc_gpio_bank_claim(struct misc_gpio_bank *bank, u32 mask)
+{
+	int err = 0;
+
+	spin_lock(&bank->lock);
+	if (bank->claimed & mask)
+		err = -EBUSY;
+	else
+		bank->claimed |= mask;
+	spin_unlock(&bank->lock);
+
+	return err;
+}
+
+static void misc_gpio_bank_unclaim(struct misc_gpio_bank *bank, u32 mask)
+{
+	spin_lock(&bank->lock);
+	bank->claimed &= ~mask;
+	spin_unlock(&bank->lock);
+}
+
+/*
+ * devm action, drops the pins of a device. The bank mapping stays until
+ * the last open file or ring mapping is gone.
+ */
+static void misc_gpio_bank_detach(void *data)
+{
+	struct driver_data *plat_data = data;
+
+	misc_gpio_bank_unclaim(plat_data->bank, plat_data->pin_mask);
+}
+
+static void misc_gpio_data_release(struct kref *ref)
+{
+	struct driver_data *plat_data =
+		container_of(ref, struct driver_data, ref);
+
+	/* nothing restarts them once dead, this is the last word */
+	misc_gpio_wave_stop(plat_data);
+	hrtimer_cancel(&plat_data->stimer);
+	hrtimer_cancel(&plat_data->pwm_timer);
+
+	vfree(plat_data->ring);
+	vfree(plat_data->runs);
+	if (plat_data->bank)
+		misc_gpio_bank_put(plat_data->bank);
+	kfree(plat_data);
+}
+
+static void misc_gpio_data_put(struct driver_data *plat_data)
+{
+	kref_put(&plat_data->ref, misc_gpio_data_release);
+}
+
+/* devm action, the device reference */
+static void misc_gpio_data_drop(void *data)
+{
+	misc_gpio_data_put(data);
+}
+
+/* "misc-pins" lists every pin of the device, "misc-id" is the one pin form */
+static int misc_gpio_of_pins(struct device_node *np, u32 *ids)
+{
+	int npins, err;
+
+	npins = of_property_count_u32_elems(np, "misc-pins");
+	if (npins <= 0) {
+		err = of_property_read_u32(np, "misc-id", &ids[0]);
+		return err ? err : 1;
+	}
+
+	if (npins > GPIO_MISC_MAX_PINS)
+		return -EINVAL;
+
+	err = of_property_read_u32_array(np, "misc-pins", ids, npins);
+	return err ? err : npins;
+}
+
+static void misc_gpio_free_irqs(struct driver_data *plat_data, int npins)
+{
+	while (npins--)
+		if (plat_data->pins[npins].irq > 0)
+			free_irq(plat_data->pins[npins].irq,
+				 &plat_data->pins[npins]);
+}
+
+/*
+ * configfs pins. mkdir /sys/kernel/config/misc_gpio/<label> creates a
+ * pin, the attributes select the device node it joins, the alive pin,
+ * the mode and its trigger or PWM timing, enable attaches it. Trigger
+ * and PWM timing changes are applied to the live pin, pin and mode
+ * changes rebuild its slot, rmdir detaches it. All of it runs under
+ * misc_gpio_devices_lock.
+ */
+struct misc_gpio_cfs_pin {
+	struct config_item item;
+	char device[32];		/* misc-name of the device */
+	u32 id;
+	int mode;
+	unsigned int trigger;		/* IRQ_TYPE_EDGE_*, input mode */
+	u32 period_ns;
+	u32 duty_ns;
+	struct misc_gpio_pin *pin;	/* slot while attached */
+};
+
+static const struct {
+	const char *name;
+	unsigned int type;
+} misc_gpio_triggers[] = {
+	{ "rising",  IRQ_TYPE_EDGE_RISING },
+	{ "falling", IRQ_TYPE_EDGE_FALLING },
+	{ "both",    IRQ_TYPE_EDGE_BOTH },
+};
+
+static inline struct misc_gpio_cfs_pin *to_cfs_pin(struct config_item *item)
+{
+	return container_of(item, struct misc_gpio_cfs_pin, item);
+}
+
+static struct driver_data *misc_gpio_find_device(const char *name)
+{
+	struct driver_data *plat_data;
 
-	const char *name;
-	u32 addr;
+	list_for_each_entry(plat_data, &misc_gpio_devices, node)
+		if (!strcmp(plat_data->name, name))
+			return plat_data;
 
-	int id;
-	struct device *dev;
-	struct miscdevice mdev;
+	return NULL;
+}
 
-	struct nx_alive_gpio_regs *palive_gpio;
-};
+static unsigned int misc_gpio_cfs_irq_type(const struct misc_gpio_cfs_pin *cfg)
+{
+	return cfg->mode == GPIO_MISC_MODE_CAPTURE ? IRQ_TYPE_EDGE_BOTH :
+						     cfg->trigger;
+}
 
+/* PWM timing of a configfs slot, bypasses the pwm core */
+static void misc_gpio_cfs_pwm_set(struct misc_gpio_pin *pin, bool enabled,
+				  u32 duty_ns, u32 period_ns)
+{
+	struct driver_data *plat_data = pin->plat_data;
+	int ch = pin - plat_data->pins;
+	unsigned long flags;
+
+	spin_lock_irqsave(&plat_data->pwm_lock, flags);
+	plat_data->pwm[ch].duty_ns = duty_ns;
+	plat_data->pwm[ch].period_ns = period_ns;
+	plat_data->pwm[ch].enabled = enabled;
+	misc_gpio_pwm_update(plat_data, ch);
+	spin_unlock_irqrestore(&plat_data->pwm_lock, flags);
+}
 
-/* misc driver fuction implementations */
-static int misc_gpio_open(struct inode *inode, struct file *file)
+/* bring a claimed slot up in the mode of its configfs pin */
+static int misc_gpio_cfs_arm(struct misc_gpio_pin *pin)
 {
-    pr_info("%s\n", __func__);
-    return 0;
+	struct driver_data *plat_data = pin->plat_data;
+	struct misc_gpio_cfs_pin *cfg = pin->cfs;
+	u32 bit = BIT(pin->id);
+	int err;
+
+	pin->mode = cfg->mode;
+
+	switch (cfg->mode) {
+	case GPIO_MISC_MODE_INPUT:
+	case GPIO_MISC_MODE_CAPTURE:
+		alive_gpio_set_directions(plat_data->palive_gpio, bit, 0);
+		pin->irq = gpio_to_irq(ALIVE_BASE + pin->id);
+		err = request_threaded_irq(pin->irq, gpio_irq_handler,
+					   gpio_interrupt_thread_fn,
+					   misc_gpio_cfs_irq_type(cfg),
+					   plat_data->name, pin);
+		if (err) {
+			pin->irq = 0;
+			return err;
+		}
+		break;
+	case GPIO_MISC_MODE_OUTPUT:
+		alive_gpio_set_values(plat_data->palive_gpio, bit, 0);
+		alive_gpio_set_directions(plat_data->palive_gpio, bit, bit);
+		break;
+	case GPIO_MISC_MODE_PWM:
+		alive_gpio_set_values(plat_data->palive_gpio, bit, 0);
+		alive_gpio_set_directions(plat_data->palive_gpio, bit, bit);
+		misc_gpio_cfs_pwm_set(pin, true, cfg->duty_ns, cfg->period_ns);
+		break;
+	}
+
+	return 0;
 }
 
-static int misc_gpio_close(struct inode *inodep, struct file *file)
+static void misc_gpio_cfs_disarm(struct misc_gpio_pin *pin)
 {
-    pr_info("%s\n", __func__);
-    return 0;
+	struct driver_data *plat_data = pin->plat_data;
+
+	if (pin->irq > 0)
+		free_irq(pin->irq, pin);
+	pin->irq = 0;
+
+	if (pin->mode == GPIO_MISC_MODE_PWM)
+		misc_gpio_cfs_pwm_set(pin, false, 0, 0);
+
+	alive_gpio_set_directions(plat_data->palive_gpio, BIT(pin->id), 0);
 }
 
-static ssize_t misc_gpio_read(struct file *filp, char __user *buf,
-			   size_t count, loff_t *f_pos)
+static int misc_gpio_cfs_attach(struct misc_gpio_cfs_pin *cfg)
 {
-    pr_info("%s\n", __func__);
-    return 0;
+	struct driver_data *plat_data = misc_gpio_find_device(cfg->device);
+	struct misc_gpio_pin *pin = NULL;
+	int i, err;
+
+	if (!plat_data)
+		return -ENODEV;
+
+	if (cfg->mode == GPIO_MISC_MODE_PWM &&
+	    (cfg->period_ns < GPIO_MISC_PWM_MIN_PERIOD_NS ||
+	     cfg->duty_ns > cfg->period_ns))
+		return -EINVAL;
+
+	for (i = 0; i < GPIO_MISC_MAX_PINS && !pin; i++)
+		if (!plat_data->pins[i].plat_data)
+			pin = &plat_data->pins[i];
+	if (!pin)
+		return -ENOSPC;
+
+	err = misc_gpio_bank_claim(plat_data->bank, BIT(cfg->id));
+	if (err)
+		return err;
+
+	memset(pin, 0, sizeof(*pin));
+	pin->plat_data = plat_data;
+	pin->id = cfg->id;
+	pin->cfs = cfg;
+
+	err = misc_gpio_cfs_arm(pin);
+	if (err) {
+		misc_gpio_bank_unclaim(plat_data->bank, BIT(cfg->id));
+		pin->plat_data = NULL;
+		return err;
+	}
+
+	WRITE_ONCE(plat_data->pin_mask, plat_data->pin_mask | BIT(pin->id));
+	if (pin - plat_data->pins >= plat_data->npins)
+		WRITE_ONCE(plat_data->npins, pin - plat_data->pins + 1);
+	cfg->pin = pin;
+
+	return 0;
 }
 
-static ssize_t misc_gpio_write(struct file *file, const char __user *buf,
-			   size_t len, loff_t *ppos)
+static void misc_gpio_cfs_detach(struct misc_gpio_cfs_pin *cfg)
 {
-    pr_info("%s\n", __func__);
-    return len;
+	struct misc_gpio_pin *pin = cfg->pin;
+	struct driver_data *plat_data;
+
+	if (!pin)
+		return;
+
+	plat_data = pin->plat_data;
+	misc_gpio_cfs_disarm(pin);
+	WRITE_ONCE(plat_data->pin_mask, plat_data->pin_mask & ~BIT(pin->id));
+	misc_gpio_bank_unclaim(plat_data->bank, BIT(pin->id));
+	pin->cfs = NULL;
+	pin->plat_data = NULL;
+	cfg->pin = NULL;
 }
 
-static long misc_gpio_ioctl(struct file *file, unsigned int cmd,
-			   unsigned long arg)
+/* move a live pin to another alive pin or mode, keeping its slot */
+static int misc_gpio_cfs_rebuild(struct misc_gpio_cfs_pin *cfg, u32 id,
+				 int mode)
 {
-    pr_info("%s\n", __func__);
-    return 0;
+	struct misc_gpio_pin *pin = cfg->pin;
+	struct driver_data *plat_data = pin->plat_data;
+	u32 old_id = cfg->id;
+	int old_mode = cfg->mode;
+	int err;
+
+	if (id != old_id) {
+		err = misc_gpio_bank_claim(plat_data->bank, BIT(id));
+		if (err)
+			return err;
+	}
+
+	misc_gpio_cfs_disarm(pin);
+	WRITE_ONCE(plat_data->pin_mask, plat_data->pin_mask & ~BIT(old_id));
+
+	cfg->id = id;
+	cfg->mode = mode;
+	pin->id = id;
+	err = misc_gpio_cfs_arm(pin);
+	if (err) {
+		/* put the pin back the way it was */
+		cfg->id = old_id;
+		cfg->mode = old_mode;
+		pin->id = old_id;
+		if (misc_gpio_cfs_arm(pin))
+			pr_err("%s: pin %u lost its irq\n", plat_data->name, old_id);
+	}
+
+	WRITE_ONCE(plat_data->pin_mask, plat_data->pin_mask | BIT(pin->id));
+	if (id != old_id)
+		misc_gpio_bank_unclaim(plat_data->bank, BIT(err ? id : old_id));
+
+	return err;
 }
 
+static ssize_t misc_gpio_cfs_device_show(struct config_item *item, char *page)
+{
+	return sprintf(page, "%s\n", to_cfs_pin(item)->device);
+}
 
-/* file operation structure */
-static const struct file_operations misc_fops = {
-	.write          = misc_gpio_write,
-	.read           = misc_gpio_read,
-	.open           = misc_gpio_open,
-	.unlocked_ioctl = misc_gpio_ioctl,
-	.release        = misc_gpio_close,
+static ssize_t misc_gpio_cfs_device_store(struct config_item *item,
+					  const char *page, size_t len)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	char name[sizeof(cfg->device)];
+	int err = 0;
+
+	if (sscanf(page, "%31s", name) != 1)
+		return -EINVAL;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	if (cfg->pin) {
+		/* retarget to another device node */
+		misc_gpio_cfs_detach(cfg);
+		strlcpy(cfg->device, name, sizeof(cfg->device));
+		err = misc_gpio_cfs_attach(cfg);
+	} else {
+		strlcpy(cfg->device, name, sizeof(cfg->device));
+	}
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return err ? err : len;
+}
+
+static ssize_t misc_gpio_cfs_pin_show(struct config_item *item, char *page)
+{
+	return sprintf(page, "%u\n", to_cfs_pin(item)->id);
+}
+
+static ssize_t misc_gpio_cfs_pin_store(struct config_item *item,
+				       const char *page, size_t len)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	u32 id;
+	int err;
+
+	err = kstrtou32(page, 0, &id);
+	if (err)
+		return err;
+	if (id >= GPIO_MISC_MAX_PINS)
+		return -EINVAL;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	if (cfg->pin && id != cfg->id)
+		err = misc_gpio_cfs_rebuild(cfg, id, cfg->mode);
+	else
+		cfg->id = id;
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return err ? err : len;
+}
+
+static ssize_t misc_gpio_cfs_mode_show(struct config_item *item, char *page)
+{
+	return sprintf(page, "%s\n",
+		       misc_gpio_mode_names[to_cfs_pin(item)->mode]);
+}
+
+static ssize_t misc_gpio_cfs_mode_store(struct config_item *item,
+					const char *page, size_t len)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	int mode, err = 0;
+
+	for (mode = 0; mode < GPIO_MISC_MODES; mode++)
+		if (sysfs_streq(page, misc_gpio_mode_names[mode]))
+			break;
+	if (mode == GPIO_MISC_MODES)
+		return -EINVAL;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	if (cfg->pin && mode != cfg->mode) {
+		if (mode == GPIO_MISC_MODE_PWM &&
+		    (cfg->period_ns < GPIO_MISC_PWM_MIN_PERIOD_NS ||
+		     cfg->duty_ns > cfg->period_ns))
+			err = -EINVAL;
+		else
+			err = misc_gpio_cfs_rebuild(cfg, cfg->id, mode);
+	} else {
+		cfg->mode = mode;
+	}
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return err ? err : len;
+}
+
+static ssize_t misc_gpio_cfs_trigger_show(struct config_item *item, char *page)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(misc_gpio_triggers); i++)
+		if (misc_gpio_triggers[i].type == cfg->trigger)
+			return sprintf(page, "%s\n", misc_gpio_triggers[i].name);
+
+	return -EINVAL;
+}
+
+static ssize_t misc_gpio_cfs_trigger_store(struct config_item *item,
+					   const char *page, size_t len)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	struct misc_gpio_pin *pin;
+	int i, err = 0;
+
+	for (i = 0; i < ARRAY_SIZE(misc_gpio_triggers); i++)
+		if (sysfs_streq(page, misc_gpio_triggers[i].name))
+			break;
+	if (i == ARRAY_SIZE(misc_gpio_triggers))
+		return -EINVAL;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	cfg->trigger = misc_gpio_triggers[i].type;
+
+	/* re-arm the live line, capture stays on both edges */
+	pin = cfg->pin;
+	if (pin && pin->mode == GPIO_MISC_MODE_INPUT)
+		err = irq_set_irq_type(pin->irq, cfg->trigger);
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return err ? err : len;
+}
+
+static ssize_t misc_gpio_cfs_timing_store(struct config_item *item,
+					  const char *page, size_t len,
+					  bool period)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	u32 duty_ns = cfg->duty_ns, period_ns = cfg->period_ns;
+	u32 val;
+	int err;
+
+	err = kstrtou32(page, 0, &val);
+	if (err)
+		return err;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	if (period)
+		period_ns = val;
+	else
+		duty_ns = val;
+
+	/* a live PWM pin takes the new timing on its next edge */
+	if (cfg->pin && cfg->mode == GPIO_MISC_MODE_PWM) {
+		if (period_ns < GPIO_MISC_PWM_MIN_PERIOD_NS ||
+		    duty_ns > period_ns)
+			err = -EINVAL;
+		else
+			misc_gpio_cfs_pwm_set(cfg->pin, true, duty_ns, period_ns);
+	}
+	if (!err) {
+		cfg->duty_ns = duty_ns;
+		cfg->period_ns = period_ns;
+	}
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return err ? err : len;
+}
+
+static ssize_t misc_gpio_cfs_period_ns_show(struct config_item *item,
+					    char *page)
+{
+	return sprintf(page, "%u\n", to_cfs_pin(item)->period_ns);
+}
+
+static ssize_t misc_gpio_cfs_period_ns_store(struct config_item *item,
+					     const char *page, size_t len)
+{
+	return misc_gpio_cfs_timing_store(item, page, len, true);
+}
+
+static ssize_t misc_gpio_cfs_duty_ns_show(struct config_item *item, char *page)
+{
+	return sprintf(page, "%u\n", to_cfs_pin(item)->duty_ns);
+}
+
+static ssize_t misc_gpio_cfs_duty_ns_store(struct config_item *item,
+					   const char *page, size_t len)
+{
+	return misc_gpio_cfs_timing_store(item, page, len, false);
+}
+
+static ssize_t misc_gpio_cfs_enable_show(struct config_item *item, char *page)
+{
+	return sprintf(page, "%d\n", !!to_cfs_pin(item)->pin);
+}
+
+static ssize_t misc_gpio_cfs_enable_store(struct config_item *item,
+					  const char *page, size_t len)
+{
+	struct misc_gpio_cfs_pin *cfg = to_cfs_pin(item);
+	bool enable;
+	int err;
+
+	err = strtobool(page, &enable);
+	if (err)
+		return err;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	if (enable && !cfg->pin)
+		err = misc_gpio_cfs_attach(cfg);
+	else if (!enable)
+		misc_gpio_cfs_detach(cfg);
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return err ? err : len;
+}
+
+CONFIGFS_ATTR(misc_gpio_cfs_, device);
+CONFIGFS_ATTR(misc_gpio_cfs_, pin);
+CONFIGFS_ATTR(misc_gpio_cfs_, mode);
+CONFIGFS_ATTR(misc_gpio_cfs_, trigger);
+CONFIGFS_ATTR(misc_gpio_cfs_, period_ns);
+CONFIGFS_ATTR(misc_gpio_cfs_, duty_ns);
+CONFIGFS_ATTR(misc_gpio_cfs_, enable);
+
+static struct configfs_attribute *misc_gpio_cfs_attrs[] = {
+	&misc_gpio_cfs_attr_device,
+	&misc_gpio_cfs_attr_pin,
+	&misc_gpio_cfs_attr_mode,
+	&misc_gpio_cfs_attr_trigger,
+	&misc_gpio_cfs_attr_period_ns,
+	&misc_gpio_cfs_attr_duty_ns,
+	&misc_gpio_cfs_attr_enable,
+	NULL,
 };
 
-/* interrupt functions */
-static enum hrtimer_restart timer_callback(struct hrtimer *timer)
+static void misc_gpio_cfs_release(struct config_item *item)
 {
-	pr_info("Callback Function: %d\n", timer->is_rel);
-	hrtimer_forward_now(timer, ktime_set(10, 0));
-	return HRTIMER_RESTART;
+	kfree(to_cfs_pin(item));
 }
 
-static irqreturn_t gpio_irq_handler(int irq, void *dev_id)
+static struct configfs_item_operations misc_gpio_cfs_item_ops = {
+	.release = misc_gpio_cfs_release,
+};
+
+static struct config_item_type misc_gpio_cfs_pin_type = {
+	.ct_item_ops = &misc_gpio_cfs_item_ops,
+	.ct_attrs    = misc_gpio_cfs_attrs,
+	.ct_owner    = THIS_MODULE,
+};
+
+static struct config_item *misc_gpio_cfs_make_item(struct config_group *group,
+						   const char *name)
 {
-	pr_info("Interrupt [%d] in top half\n", irq);
-	return IRQ_WAKE_THREAD;
+	struct misc_gpio_cfs_pin *cfg;
+
+	cfg = kzalloc(sizeof(*cfg), GFP_KERNEL);
+	if (!cfg)
+		return ERR_PTR(-ENOMEM);
+
+	cfg->trigger = IRQ_TYPE_EDGE_BOTH;
+	config_item_init_type_name(&cfg->item, name, &misc_gpio_cfs_pin_type);
+
+	return &cfg->item;
 }
 
-static irqreturn_t gpio_interrupt_thread_fn(int irq, void *dev_id)
+static void misc_gpio_cfs_drop_item(struct config_group *group,
+				    struct config_item *item)
 {
-	pr_info("Interrupt [%d] in bottom half\n", irq);
-	return IRQ_HANDLED;
+	mutex_lock(&misc_gpio_devices_lock);
+	misc_gpio_cfs_detach(to_cfs_pin(item));
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	config_item_put(item);
 }
 
+static struct configfs_group_operations misc_gpio_cfs_group_ops = {
+	.make_item = misc_gpio_cfs_make_item,
+	.drop_item = misc_gpio_cfs_drop_item,
+};
+
+static struct config_item_type misc_gpio_cfs_type = {
+	.ct_group_ops = &misc_gpio_cfs_group_ops,
+	.ct_owner     = THIS_MODULE,
+};
+
+static struct configfs_subsystem misc_gpio_cfs_subsys = {
+	.su_group = {
+		.cg_item = {
+			.ci_namebuf = "misc_gpio",
+			.ci_type    = &misc_gpio_cfs_type,
+		},
+	},
+};
 
 /* platform_probe */
 static int platform_probe(struct platform_device *pdev)
 {
 	struct driver_data *plat_data;
+	struct misc_gpio_bank *bank;
+	struct misc_gpio_pin *pin;
 
 	struct miscdevice misc_gpio_driver = {
 		.minor = MISC_DYNAMIC_MINOR,
 		.fops = &misc_fops,
+		.groups = misc_gpio_groups,
 	};
 
 	const char *name;
 	u32 addr;
-	struct nx_alive_gpio_regs *palive;
 	struct device *dev = &pdev->dev;
-	ktime_t ktime;
 
-	int err, id, irq;
+	u32 ids[GPIO_MISC_MAX_PINS];
+	int err, npins, i;
 
 	if (!dev->of_node) {
 		dev_err(dev, "device tree node error\n");
 		return -ENODEV;
 	}
 
-	plat_data = devm_kzalloc(dev, sizeof(*plat_data), GFP_KERNEL);
+	plat_data = kzalloc(sizeof(*plat_data), GFP_KERNEL);
+	if (!plat_data)
+		return -ENOMEM;
+	kref_init(&plat_data->ref);
+	init_rwsem(&plat_data->dead_lock);
+
+	/* ready before the first put, the release cancels them */
+	spin_lock_init(&plat_data->wave_lock);
+	hrtimer_init(&plat_data->htimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	plat_data->htimer.function = &timer_callback;
+
+	mutex_init(&plat_data->sample_lock);
+	hrtimer_init(&plat_data->stimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	plat_data->stimer.function = &sampler_callback;
+
+	spin_lock_init(&plat_data->pwm_lock);
+	hrtimer_init(&plat_data->pwm_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	plat_data->pwm_timer.function = &pwm_timer_callback;
+
+	err = devm_add_action(dev, misc_gpio_data_drop, plat_data);
+	if (err) {
+		kfree(plat_data);
+		return err;
+	}
 
 	err = of_property_read_string(pdev->dev.of_node, "misc-name", &name);
 	if (err) {
@@ -123,43 +2638,76 @@ static int platform_probe(struct platform_device *pdev)
 	}
 	pr_info("Device Base addr : %08X\n", addr);
 
-	err = of_property_read_u32(pdev->dev.of_node, "misc-id", &id);
-	if (err) {
+	npins = misc_gpio_of_pins(pdev->dev.of_node, ids);
+	if (npins < 0) {
 		pr_err("ERROR : id error!\n");
-		return err;
+		return npins;
+	}
+
+	for (i = 0; i < npins; i++) {
+		if (ids[i] >= GPIO_MISC_MAX_PINS ||
+		    (plat_data->pin_mask & BIT(ids[i]))) {
+			pr_err("ERROR : pin %u error!\n", ids[i]);
+			return -EINVAL;
+		}
+		pr_info("Misc Device pin  : %u\n", ids[i]);
+
+		plat_data->pins[i].plat_data = plat_data;
+		plat_data->pins[i].id = ids[i];
+		plat_data->pin_mask |= BIT(ids[i]);
 	}
-	pr_info("Misc Device pin  : %d\n", id);
 
-	plat_data->id = id;
+	plat_data->npins = npins;
 	plat_data->name = name;
 	plat_data->dev = dev;
-	plat_data->ktime = ktime;
-	palive = (struct nx_alive_gpio_regs *)(addr);
-	plat_data->palive_gpio = palive;
-
-	alive_gpio_direction_input(plat_data->palive_gpio, plat_data->id);
-	mdelay(10);
-
-	irq = gpio_to_irq(ALIVE_BASE + plat_data->id);
-	pr_info("IRQ number   : %d\n", irq);
+	plat_data->addr = addr;
+	spin_lock_init(&plat_data->event_lock);
+	mutex_init(&plat_data->read_lock);
+	mutex_init(&plat_data->clients_lock);
+	INIT_LIST_HEAD(&plat_data->clients);
+	init_waitqueue_head(&plat_data->wait);
+	mutex_init(&plat_data->wake_lock);
+
+	/* every node on the same alive block shares one mapping */
+	bank = misc_gpio_bank_get(addr);
+	if (IS_ERR(bank))
+		return PTR_ERR(bank);
+	plat_data->bank = bank;
+
+	err = misc_gpio_bank_claim(plat_data->bank, plat_data->pin_mask);
+	if (err) {
+		pr_err("ERROR : pins %08X owned by another node!\n",
+		       plat_data->pin_mask);
+		return err;
+	}
 
-	if (request_threaded_irq(irq,
-		(void *)gpio_irq_handler,
-		gpio_interrupt_thread_fn,
-		IRQF_TRIGGER_RISING |
-		IRQF_TRIGGER_FALLING,
-		plat_data->name, NULL)) {
-		pr_err("my_device: cannot register IRQ %d\n", irq);
+	err = devm_add_action(dev, misc_gpio_bank_detach, plat_data);
+	if (err) {
+		misc_gpio_bank_detach(plat_data);
+		return err;
 	}
+	plat_data->palive_gpio = plat_data->bank->regs;
 
-	plat_data->ktime = ktime_set(0, 0);
-	mdelay(10);
-	hrtimer_init(&plat_data->htimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	plat_data->lat = devm_alloc_percpu(dev, struct misc_gpio_lat);
+	if (!plat_data->lat)
+		return -ENOMEM;
 
-	plat_data->htimer.is_rel = plat_data->id;
+	alive_gpio_set_directions(plat_data->palive_gpio, plat_data->pin_mask, 0);
+	mdelay(10);
 
-	plat_data->htimer.function = &timer_callback;
-	hrtimer_start(&plat_data->htimer, plat_data->ktime, HRTIMER_MODE_REL);
+	if (bench_loops)
+		misc_gpio_bench(plat_data);
+
+	/* every pin feeds the same handler pair with its own channel */
+	for (i = 0; i < plat_data->npins; i++) {
+		pin = &plat_data->pins[i];
+		err = misc_gpio_request_pin_irq(pin);
+		if (err) {
+			misc_gpio_free_irqs(plat_data, i);
+			return err;
+		}
+		pr_info("IRQ number   : %d\n", pin->irq);
+	}
 
 	misc_gpio_driver.name = plat_data->name;
 	plat_data->mdev = misc_gpio_driver;
@@ -167,30 +2715,268 @@ static int platform_probe(struct platform_device *pdev)
 
 	if (err) {
 		pr_err("misc_register failed\n");
+		misc_gpio_free_irqs(plat_data, plat_data->npins);
+		return err;
+	}
+
+	/* one PWM channel per pin, in misc-pins order */
+	plat_data->pwm_chip.dev = dev;
+	plat_data->pwm_chip.ops = &misc_gpio_pwm_ops;
+	plat_data->pwm_chip.base = -1;
+	plat_data->pwm_chip.npwm = plat_data->npins;
+	err = pwmchip_add(&plat_data->pwm_chip);
+	if (err) {
+		pr_err("pwmchip_add failed\n");
+		misc_deregister(&plat_data->mdev);
+		misc_gpio_free_irqs(plat_data, plat_data->npins);
 		return err;
 	}
 
+	plat_data->debugfs = debugfs_create_dir(plat_data->name, NULL);
+	debugfs_create_u32("sample_rate_hz", 0400, plat_data->debugfs,
+			   &plat_data->sample_rate);
+	debugfs_create_u64("sample_missed", 0400, plat_data->debugfs,
+			   &plat_data->sample_missed);
+	debugfs_create_file("samples", 0400, plat_data->debugfs, plat_data,
+			    &sampler_raw_fops);
+	debugfs_create_file("samples.vcd", 0400, plat_data->debugfs, plat_data,
+			    &sampler_vcd_fops);
+	debugfs_create_file("latency", 0400, plat_data->debugfs, plat_data,
+			    &latency_fops);
+	debugfs_create_file("latency_reset", 0200, plat_data->debugfs, plat_data,
+			    &latency_reset_fops);
+	debugfs_create_u64("pwm_ticks", 0400, plat_data->debugfs,
+			   &plat_data->pwm_ticks);
+	debugfs_create_u64("pwm_writes", 0400, plat_data->debugfs,
+			   &plat_data->pwm_writes);
+	debugfs_create_u64("pwm_missed", 0400, plat_data->debugfs,
+			   &plat_data->pwm_missed);
+	debugfs_create_u64("pm_restore_ns", 0400, plat_data->debugfs,
+			   &plat_data->pm_restore_ns);
+
 	platform_set_drvdata(pdev, plat_data);
 
+	/* alive pins can wake the system, "wakeup-source" arms all of them */
+	device_init_wakeup(dev, true);
+	if (of_property_read_bool(pdev->dev.of_node, "wakeup-source"))
+		plat_data->wake_mask = plat_data->pin_mask;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	list_add_tail(&plat_data->node, &misc_gpio_devices);
+	mutex_unlock(&misc_gpio_devices_lock);
+
 	return 0;
 };
 
 /* platform_remove */
 static int platform_remove(struct platform_device *pdev)
 {
-	int irq;
 	struct driver_data *plat_data;
+	int i, err;
 
 	plat_data = platform_get_drvdata(pdev);
-	hrtimer_cancel(&plat_data->htimer);
-	irq = gpio_to_irq(ALIVE_BASE + plat_data->id);
-	free_irq(irq, NULL);
+
+	/*
+	 * Requested and exported channels hold the module and sysfs unbind is
+	 * off, so this only fails when the device itself goes away under a
+	 * channel. The chip then stays registered and keeps plat_data, its
+	 * ops fail from the dead check on.
+	 */
+	err = pwmchip_remove(&plat_data->pwm_chip);
+	if (err) {
+		dev_err(&pdev->dev, "pwm channels in use, chip left registered\n");
+		kref_get(&plat_data->ref);
+	}
+
+	/*
+	 * no new open() past this point, files and mappings still open keep
+	 * plat_data, the ring and the bank mapping through their reference
+	 */
 	misc_deregister(&plat_data->mdev);
 
+	/* open files fail from here, nothing they started survives below */
+	down_write(&plat_data->dead_lock);
+	plat_data->dead = true;
+	up_write(&plat_data->dead_lock);
+
+	/* configfs pins stay, disabled, until they are enabled on a new node */
+	mutex_lock(&misc_gpio_devices_lock);
+	list_del(&plat_data->node);
+	for (i = 0; i < plat_data->npins; i++)
+		if (plat_data->pins[i].cfs)
+			misc_gpio_cfs_detach(plat_data->pins[i].cfs);
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	debugfs_remove_recursive(plat_data->debugfs);
+	device_init_wakeup(&pdev->dev, false);
+	misc_gpio_pwm_stop(plat_data);
+	misc_gpio_wave_stop(plat_data);
+	misc_gpio_sampler_stop(plat_data);
+	misc_gpio_free_irqs(plat_data, plat_data->npins);
+
 	pr_info("%s\n", __func__);
 	return 0;
 }
 
+#ifdef CONFIG_PM_SLEEP
+/*
+ * Arm the wake pins as wakeup interrupts, except those that woke the
+ * system less than the hold-off ago. Input slots of configfs pins only
+ * change under misc_gpio_devices_lock.
+ */
+static int misc_gpio_suspend(struct device *dev)
+{
+	struct driver_data *plat_data = dev_get_drvdata(dev);
+	u64 now = ktime_get_boot_ns();
+	struct misc_gpio_pin *pin;
+	int i;
+
+	if (!device_may_wakeup(dev))
+		return 0;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	mutex_lock(&plat_data->wake_lock);
+	for (i = 0; i < plat_data->npins; i++) {
+		pin = &plat_data->pins[i];
+		if (!pin->plat_data || pin->irq <= 0 ||
+		    !(plat_data->wake_mask & BIT(pin->id)))
+			continue;
+
+		if (pin->wake_last_ns &&
+		    now - pin->wake_last_ns < plat_data->wake_holdoff_ns) {
+			plat_data->wake_held_off++;
+			continue;
+		}
+
+		if (!enable_irq_wake(pin->irq))
+			plat_data->wake_armed |= BIT(pin->id);
+	}
+	mutex_unlock(&plat_data->wake_lock);
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return 0;
+}
+
+static int misc_gpio_resume(struct device *dev)
+{
+	struct driver_data *plat_data = dev_get_drvdata(dev);
+	struct misc_gpio_pin *pin;
+	int i;
+
+	mutex_lock(&misc_gpio_devices_lock);
+	mutex_lock(&plat_data->wake_lock);
+	for (i = 0; i < plat_data->npins; i++) {
+		pin = &plat_data->pins[i];
+		if (pin->plat_data && pin->irq > 0 &&
+		    (plat_data->wake_armed & BIT(pin->id)))
+			disable_irq_wake(pin->irq);
+	}
+	plat_data->wake_armed = 0;
+	mutex_unlock(&plat_data->wake_lock);
+	mutex_unlock(&misc_gpio_devices_lock);
+
+	return 0;
+}
+
+/* log the armed pins still pending at resume, one record per pin */
+static void misc_gpio_wake_log(struct driver_data *plat_data, u32 woke)
+{
+	struct gpio_misc_wake_event *ev;
+	struct misc_gpio_pin *pin;
+	u64 boot_ns = ktime_get_boot_ns();
+	u64 now = ktime_get_ns();
+	u32 levels = alive_gpio_get_values(plat_data->palive_gpio, woke);
+	int i;
+
+	mutex_lock(&plat_data->wake_lock);
+	for (i = 0; i < plat_data->npins; i++) {
+		pin = &plat_data->pins[i];
+		if (!pin->plat_data || !(woke & BIT(pin->id)))
+			continue;
+
+		pin->wake_last_ns = boot_ns;
+
+		if (plat_data->wake_head - plat_data->wake_tail ==
+		    GPIO_MISC_WAKE_EVENTS) {
+			plat_data->wake_tail++;
+			plat_data->wake_lost++;
+		}
+		ev = &plat_data->wake_events[plat_data->wake_head++ %
+					     GPIO_MISC_WAKE_EVENTS];
+		ev->timestamp_ns = now;
+		ev->suspend_ns = boot_ns - plat_data->suspend_boot_ns;
+		ev->seq = plat_data->wake_seq++;
+		ev->pin = pin->id;
+		ev->edge = levels & BIT(pin->id) ? GPIO_MISC_EDGE_RISING :
+						   GPIO_MISC_EDGE_FALLING;
+		ev->reserved = 0;
+	}
+	mutex_unlock(&plat_data->wake_lock);
+
+	pm_wakeup_event(plat_data->dev, 0);
+}
+
+/*
+ * Snapshot the direction, output level and detect configuration of the
+ * managed pins in one pass, restore them with masked SET/RESET writes
+ * before interrupts come back, so user space does not have to.
+ */
+static int misc_gpio_suspend_noirq(struct device *dev)
+{
+	struct driver_data *plat_data = dev_get_drvdata(dev);
+	struct nx_alive_gpio_regs __iomem *regs = plat_data->palive_gpio;
+	u32 mask = plat_data->pin_mask;
+	int i;
+
+	plat_data->pm_outenb = ioread32(&regs->outputenb_read) & mask;
+	plat_data->pm_out = ioread32(&regs->pad_read) & mask;
+	for (i = 0; i < NX_ALIVE_DET_MODES; i++)
+		plat_data->pm_detmode[i] = ioread32(&regs->detmode[i].read) & mask;
+	plat_data->pm_detenb = ioread32(&regs->detenb.read) & mask;
+	plat_data->pm_intenb = ioread32(&regs->intenb.read) & mask;
+	plat_data->suspend_boot_ns = ktime_get_boot_ns();
+
+	return 0;
+}
+
+static int misc_gpio_resume_noirq(struct device *dev)
+{
+	struct driver_data *plat_data = dev_get_drvdata(dev);
+	struct nx_alive_gpio_regs __iomem *regs = plat_data->palive_gpio;
+	u32 mask = plat_data->pin_mask;
+	u64 start = ktime_get_ns();
+	u32 woke = ioread32(&regs->pend) & plat_data->wake_armed;
+	int i;
+
+	/* levels before directions, so outputs come up at their old level */
+	alive_gpio_set_values(regs, mask, plat_data->pm_out);
+	alive_gpio_set_directions(regs, mask, plat_data->pm_outenb);
+
+	/* detect modes, then drop what latched meanwhile, then the enables */
+	for (i = 0; i < NX_ALIVE_DET_MODES; i++)
+		alive_gpio_rsr_write(&regs->detmode[i], mask,
+				     plat_data->pm_detmode[i]);
+	alive_gpio_rsr_write(&regs->detenb, mask, plat_data->pm_detenb);
+	iowrite32(mask & ~plat_data->pm_intenb, &regs->pend);
+	alive_gpio_rsr_write(&regs->intenb, mask, plat_data->pm_intenb);
+
+	plat_data->pm_restore_ns = ktime_get_ns() - start;
+	dev_dbg(dev, "restored pins %08x in %llu ns\n", mask,
+		plat_data->pm_restore_ns);
+
+	if (woke)
+		misc_gpio_wake_log(plat_data, woke);
+
+	return 0;
+}
+#endif
+
+static const struct dev_pm_ops misc_gpio_pm_ops = {
+	SET_SYSTEM_SLEEP_PM_OPS(misc_gpio_suspend, misc_gpio_resume)
+	SET_NOIRQ_SYSTEM_SLEEP_PM_OPS(misc_gpio_suspend_noirq,
+				      misc_gpio_resume_noirq)
+};
+
 static const struct of_device_id misc_gpio_match[] = {
 	{.compatible = "nexell,misc_gpio"},
 	{},
@@ -203,6 +2989,9 @@ static struct platform_driver platform_gpio_driver = {
 	.driver = {
 		.name = "misc_gpio_driver",
 		.of_match_table = misc_gpio_match,
+		.pm = &misc_gpio_pm_ops,
+		/* a requested PWM channel must not lose its chip */
+		.suppress_bind_attrs = true,
 	},
 };
 
@@ -216,96 +3005,90 @@ static int __init misc_gpio_driver_init(void)
 		pr_err("plat_register failed\n");
 		return error;
 	}
+
+	config_group_init(&misc_gpio_cfs_subsys.su_group);
+	mutex_init(&misc_gpio_cfs_subsys.su_mutex);
+	error = configfs_register_subsystem(&misc_gpio_cfs_subsys);
+	if (error) {
+		pr_err("configfs_register_subsystem failed\n");
+		platform_driver_unregister(&platform_gpio_driver);
+		return error;
+	}
 	return 0;
 }
 
 /* misc_gpio_driver_exit */
 static void __exit misc_gpio_driver_exit(void)
 {
+	configfs_unregister_subsystem(&misc_gpio_cfs_subsys);
 	platform_driver_unregister(&platform_gpio_driver);
 	pr_info("%s\n", __func__);
 }
 
 /* driver helper fuctions */
-u32 misc_getbit(u32 base, unsigned pin)
-{
-	void *pvaddr;
-	unsigned int value;
-	unsigned int mask;
-
-	pvaddr = ioremap((u32)base, 32);
-	value = ioread32(pvaddr);
-
-	mask = 1UL << pin;
-	value = (value & mask) >> pin;
-
-	return value;
-}
-
-/* driver helper fuctions */
-void misc_setbit(u32 base, unsigned pin)
+u32 alive_gpio_get_value(struct nx_alive_gpio_regs __iomem *base, unsigned pin)
 {
-	void *pvaddr;
-	unsigned int value;
-	unsigned int mask;
-
-	pvaddr = ioremap((u32)base, 32);
-	value = ioread32(pvaddr);
-
-	mask = 1UL << pin;
-	value = (value | mask);
-
-	iowrite32(value, pvaddr);
+	return misc_getbit(&base->pad, pin);
 }
 
-/* driver helper fuctions */
-void misc_clrbit(u32 base, unsigned pin)
+void alive_gpio_direction_output(struct nx_alive_gpio_regs __iomem *base,
+unsigned pin, int val)
 {
-	void *pvaddr;
-	unsigned int value;
-	unsigned int mask;
-
-	pvaddr = ioremap((u32)base, 32);
-	value = ioread32(pvaddr);
-
-	mask = 1UL << pin;
-	value = value & ~mask;
+	if (val)
+		misc_setbit(&base->data, pin);
+	else
+		misc_setbit(&base->pad_reset, pin);
 
-	iowrite32(value, pvaddr);
+	misc_setbit(&base->outputenb, pin);
 }
 
-u32 alive_gpio_get_value(struct nx_alive_gpio_regs const *base, unsigned pin)
+void alive_gpio_direction_input(struct nx_alive_gpio_regs __iomem *base,
+unsigned pin)
 {
-	u32 value;
-
-	value = misc_getbit((u32)&(base->pad), pin);
-	return value;
+	misc_setbit(&base->outputenb_reset, pin);
 }
 
-void alive_gpio_direction_output(struct nx_alive_gpio_regs const *base,
+void alive_gpio_set_value(struct nx_alive_gpio_regs __iomem *base,
 unsigned pin, int val)
 {
 	if (val)
-		misc_setbit((u32)(&base->data), pin);
+		misc_setbit(&base->data, pin);
 	else
-		misc_setbit((u32)(&base->pad_reset), pin);
+		misc_setbit(&base->pad_reset, pin);
+}
 
-	misc_setbit((u32)(&base->outputenb), pin);
+/*
+ * Multi-pin helpers. The alive block has separate set and reset
+ * registers for the output level and the output enable, so a masked
+ * update is one write per register and needs no read-modify-write.
+ */
+u32 alive_gpio_get_values(struct nx_alive_gpio_regs __iomem *base, u32 mask)
+{
+	return ioread32(&base->pad) & mask;
 }
 
-void alive_gpio_direction_input(struct nx_alive_gpio_regs const *base,
-unsigned pin)
+u32 alive_gpio_get_directions(struct nx_alive_gpio_regs __iomem *base,
+u32 mask)
 {
-	misc_setbit((u32)(&base->outputenb_reset), pin);
+	return ioread32(&base->outputenb_read) & mask;
 }
 
-void alive_gpio_set_value(struct nx_alive_gpio_regs const *base,
-unsigned pin, int val)
+void alive_gpio_set_values(struct nx_alive_gpio_regs __iomem *base,
+u32 mask, u32 bits)
 {
-	if (val)
-		misc_setbit((u32)(&base->data), pin);
-	else
-		misc_clrbit((u32)(&base->pad_reset), pin);
+	if (mask & bits)
+		iowrite32(mask & bits, &base->data);
+	if (mask & ~bits)
+		iowrite32(mask & ~bits, &base->pad_reset);
+}
+
+void alive_gpio_set_directions(struct nx_alive_gpio_regs __iomem *base,
+u32 mask, u32 outputs)
+{
+	if (mask & outputs)
+		iowrite32(mask & outputs, &base->outputenb);
+	if (mask & ~outputs)
+		iowrite32(mask & ~outputs, &base->outputenb_reset);
 }
 
 module_init(misc_gpio_driver_init);
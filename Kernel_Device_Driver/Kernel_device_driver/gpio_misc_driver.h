@@ -15,9 +15,28 @@
 #include <asm/io.h>
 #include <linux/time.h>
 #include <linux/hrtimer.h>
+#include <linux/pwm.h>
 #include <linux/ktime.h>
 #include <linux/delay.h>
 #include <linux/interrupt.h>
+#include <linux/kfifo.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/percpu.h>
+#include <linux/mutex.h>
+#include <linux/rwsem.h>
+#include <linux/kref.h>
+#include <linux/configfs.h>
+#include <linux/list.h>
+#include <linux/rculist.h>
+#include <linux/uaccess.h>
+
+#include "gpio_misc_uapi.h"
 
 struct nx_gpio_regs
 {
@@ -29,10 +48,33 @@ struct nx_gpio_regs
 	u32	pad;		/* Pad Status Register */
 };
 
+/* alive RESET/SET/READ register triple, writes only touch the 1 bits */
+struct nx_alive_rsr
+{
+	u32	reset;
+	u32	set;
+	u32	read;
+};
+
+/* alive detect mode triples, in register order */
+enum {
+	NX_ALIVE_DET_ASYNC_LOW,
+	NX_ALIVE_DET_ASYNC_HIGH,
+	NX_ALIVE_DET_FALLING,
+	NX_ALIVE_DET_RISING,
+	NX_ALIVE_DET_LOW,
+	NX_ALIVE_DET_HIGH,
+	NX_ALIVE_DET_MODES,
+};
+
 struct nx_alive_gpio_regs 
 {
 	u32	pwrgate;	/* Power Gating Register */
-	u32	reserved0[28];	/* Reserved0 */
+	struct nx_alive_rsr detmode[NX_ALIVE_DET_MODES]; /* Detect Mode Registers */
+	struct nx_alive_rsr detenb;	/* Detect Enable Registers */
+	struct nx_alive_rsr intenb;	/* Interrupt Enable Registers */
+	u32	pend;		/* Detect Pending Register, write 1 to clear */
+	struct nx_alive_rsr scratch;	/* boot/resume signature, BSP owned */
 	u32	outputenb_reset;/* Alive GPIO Output Enable Reset Register */
 	u32	outputenb;	/* Alive GPIO Output Enable Register */
 	u32	outputenb_read; /* Alive GPIO Output Read Register */
@@ -44,13 +86,40 @@ struct nx_alive_gpio_regs
 	u32	pad;		/* Alive GPIO Input Value Register */
 };
 
-u32 misc_getbit(u32 base, unsigned pin);
-void misc_setbit(u32 base, unsigned pin);
-void misc_clrbit(u32 base, unsigned pin);
+/*
+ * register accessors on the persistent alive mapping. The output and
+ * output enable registers come as RESET/SET/READ triples: writing a 1
+ * to the SET or RESET register changes only that pin, so misc_setbit()
+ * writes the pin bit alone and needs no read-modify-write or lock.
+ */
+static inline u32 misc_getbit(void __iomem *reg, unsigned pin)
+{
+	return (ioread32(reg) >> pin) & 1;
+}
+
+static inline void misc_setbit(void __iomem *reg, unsigned pin)
+{
+	iowrite32(1UL << pin, reg);
+}
+
+/* drive the mask bits of a whole triple to bits, set and reset writes only */
+static inline void alive_gpio_rsr_write(struct nx_alive_rsr __iomem *reg,
+					u32 mask, u32 bits)
+{
+	if (mask & bits)
+		iowrite32(mask & bits, &reg->set);
+	if (mask & ~bits)
+		iowrite32(mask & ~bits, &reg->reset);
+}
+
+u32 alive_gpio_get_value(struct nx_alive_gpio_regs __iomem *base, unsigned pin);
+void alive_gpio_direction_output(struct nx_alive_gpio_regs __iomem *base, unsigned pin, int val);
+void alive_gpio_direction_input(struct nx_alive_gpio_regs __iomem *base, unsigned pin);
+void alive_gpio_set_value(struct nx_alive_gpio_regs __iomem *base, unsigned pin, int val);
 
-u32 alive_gpio_get_value(struct nx_alive_gpio_regs const *base, unsigned pin);
-void alive_gpio_direction_output(struct nx_alive_gpio_regs const *base, unsigned pin, int val);
-void alive_gpio_direction_input(struct nx_alive_gpio_regs const *base, unsigned pin);
-void alive_gpio_set_value(struct nx_alive_gpio_regs const *base, unsigned pin, int val);
+u32 alive_gpio_get_values(struct nx_alive_gpio_regs __iomem *base, u32 mask);
+u32 alive_gpio_get_directions(struct nx_alive_gpio_regs __iomem *base, u32 mask);
+void alive_gpio_set_values(struct nx_alive_gpio_regs __iomem *base, u32 mask, u32 bits);
+void alive_gpio_set_directions(struct nx_alive_gpio_regs __iomem *base, u32 mask, u32 outputs);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,209 @@
+#ifndef GPIO_MISC_UAPI_H
+#define GPIO_MISC_UAPI_H
+
+/* user space interface of the misc gpio driver, shared with the test apps */
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define GPIO_MISC_EDGE_FALLING	0
+#define GPIO_MISC_EDGE_RISING	1
+
+/*
+ * edge event record, read() returns a whole number of these. Every
+ * open() has a private queue that only takes the edges passing its
+ * filter, so seq has gaps for filtered pins; drops show in overflow.
+ */
+struct gpio_misc_event {
+	__u64	timestamp_ns;	/* monotonic time taken in the top half */
+	__u32	seq;		/* device wide edge sequence number */
+	__u16	overflow;	/* events this queue dropped right before this one */
+	__u8	pin;		/* alive pin number */
+	__u8	edge;		/* GPIO_MISC_EDGE_* */
+};
+
+/*
+ * mmap() ring: offset 0 maps this header page, the records start at
+ * record_offset. head and tail are free running, a record lives at
+ * index (n & (size - 1)). The driver publishes head with release
+ * semantics, user space loads it with acquire, consumes records up to
+ * it, then stores tail with release. poll() is only needed once the
+ * ring has been drained.
+ */
+#define GPIO_MISC_RING_RECORDS	4096
+
+struct gpio_misc_ring_header {
+	__u32	head;		/* next record the driver writes */
+	__u32	tail;		/* next record user space reads */
+	__u32	size;		/* number of records */
+	__u32	record_offset;	/* byte offset of the first record */
+	__u32	overflow;	/* records dropped while the ring was full */
+};
+
+/*
+ * write() takes a program of these instructions and runs it against the
+ * alive registers in kernel context. Delays chain from the program start
+ * so they do not drift. The values taken by GPIO_MISC_OP_SAMPLE are
+ * returned as __u32 words by the following read()s.
+ */
+#define GPIO_MISC_OP_SET	0	/* drive mask high */
+#define GPIO_MISC_OP_CLEAR	1	/* drive mask low */
+#define GPIO_MISC_OP_WRITE	2	/* drive mask to value */
+#define GPIO_MISC_OP_DELAY_NS	3	/* busy wait arg ns */
+#define GPIO_MISC_OP_WAIT_LEVEL	4	/* wait for pad & mask == value, arg ns timeout */
+#define GPIO_MISC_OP_SAMPLE	5	/* record pad & mask */
+
+#define GPIO_MISC_PROG_MAX_INSNS	256
+#define GPIO_MISC_PROG_MAX_NS		1000000	/* total delay and wait budget */
+
+struct gpio_misc_insn {
+	__u8	op;		/* GPIO_MISC_OP_* */
+	__u8	reserved[3];	/* must be zero */
+	__u32	mask;
+	__u32	value;
+	__u32	arg;
+};
+
+/* ioctl ABI, GPIO_MISC_IOC_GET_VERSION reports GPIO_MISC_ABI_VERSION */
+#define GPIO_MISC_ABI_VERSION	3
+#define GPIO_MISC_IOC_MAGIC	'G'
+
+/* masked multi-pin request, bit n is alive pin n */
+struct gpio_misc_line_values {
+	__u32	mask;		/* pins to act on */
+	__u32	bits;		/* levels, or 1 = output for directions */
+	__u32	padding[2];	/* reserved, must be zero */
+};
+
+/*
+ * Waveform playback. The device hrtimer writes each step's value to its
+ * mask, then waits duration_ns. One buffer plays while the next one is
+ * queued behind it. A looping buffer repeats until another one is queued.
+ * A buffer that runs out with nothing queued stops the engine and counts
+ * as an underrun, unless it was submitted with GPIO_MISC_WAVE_LAST.
+ */
+#define GPIO_MISC_WAVE_LOOP		(1 << 0)
+#define GPIO_MISC_WAVE_LAST		(1 << 1)
+#define GPIO_MISC_WAVE_MAX_STEPS	4096
+#define GPIO_MISC_WAVE_MIN_NS		10000
+
+struct gpio_misc_wave_step {
+	__u32	duration_ns;	/* time until the next step */
+	__u32	mask;
+	__u32	value;
+	__u32	reserved;	/* must be zero */
+};
+
+struct gpio_misc_wave {
+	__u64	steps;		/* user pointer to struct gpio_misc_wave_step[] */
+	__u32	nsteps;
+	__u32	flags;		/* GPIO_MISC_WAVE_* */
+};
+
+struct gpio_misc_wave_stats {
+	__u64	steps;			/* steps played */
+	__u64	overshoot_max_ns;	/* worst timer lateness */
+	__u64	overshoot_total_ns;
+	__u32	buffers;		/* buffers played to the end */
+	__u32	underruns;		/* buffers that ran dry */
+	__u32	running;
+	__u32	queued;
+};
+
+/* pulse capture snapshot of one input pin, widths are high pulses */
+struct gpio_misc_capture {
+	__u64	edges;		/* edges seen since the last reset */
+	__u64	period_ns;	/* last rising to rising edge */
+	__u64	high_ns;	/* last high pulse */
+	__u64	width_min_ns;
+	__u64	width_max_ns;
+	__u64	width_avg_ns;
+	__u32	duty_permille;	/* high_ns per period_ns */
+	__u32	pin;		/* pin to snapshot, set by the caller */
+};
+
+/*
+ * Pad sampler. An hrtimer reads the whole 32-bit pad register at rate_hz
+ * and keeps the masked values run-length encoded in a ring of
+ * GPIO_MISC_SAMPLER_RUNS runs, overwriting the oldest. Once the sampler
+ * is stopped, debugfs <misc-name>/samples returns the runs as raw
+ * struct gpio_misc_sample_run records and <misc-name>/samples.vcd as a
+ * VCD trace.
+ */
+#define GPIO_MISC_SAMPLER_MIN_HZ	10000
+#define GPIO_MISC_SAMPLER_MAX_HZ	200000
+#define GPIO_MISC_SAMPLER_RUNS		65536
+
+struct gpio_misc_sampler {
+	__u32	rate_hz;
+	__u32	mask;		/* pad bits to keep, 0 keeps all */
+};
+
+struct gpio_misc_sample_run {
+	__u32	value;		/* masked pad register */
+	__u32	count;		/* sample periods it was held */
+};
+
+/*
+ * Event filter of the calling open(). A new open() queues every pin and
+ * both edges. lost returns the events this queue dropped because it was
+ * full, counted since open().
+ */
+#define GPIO_MISC_EDGE_MASK(edge)	(1 << (edge))
+
+struct gpio_misc_filter {
+	__u32	pins;		/* bit n queues alive pin n */
+	__u32	edges;		/* GPIO_MISC_EDGE_MASK() bits */
+	__u32	lost;		/* out: queue drops since open() */
+	__u32	reserved;	/* must be zero */
+};
+
+/*
+ * System wakeup. GPIO_MISC_IOC_SET_WAKE makes the input pins in pins
+ * wakeup sources. A pin that woke the system is not armed again for
+ * suspends entered less than holdoff_ms after that wake, so a chattering
+ * input cannot keep waking it; every such skip counts in held_off.
+ * Each wake by an armed pin is logged in a ring of GPIO_MISC_WAKE_EVENTS
+ * records, overwriting the oldest, GPIO_MISC_IOC_WAKE_EVENTS drains it
+ * oldest first.
+ */
+#define GPIO_MISC_WAKE_EVENTS	64
+
+struct gpio_misc_wake {
+	__u32	pins;		/* bit n arms alive pin n */
+	__u32	holdoff_ms;	/* 0 disables the hold-off */
+	__u32	wakes;		/* out: wake events logged since probe */
+	__u32	held_off;	/* out: pin arms skipped by the hold-off */
+};
+
+struct gpio_misc_wake_event {
+	__u64	timestamp_ns;	/* monotonic time of the resume */
+	__u64	suspend_ns;	/* time spent suspended */
+	__u32	seq;		/* wake event number since probe */
+	__u8	pin;		/* alive pin number */
+	__u8	edge;		/* GPIO_MISC_EDGE_*, from the level at resume */
+	__u16	reserved;
+};
+
+struct gpio_misc_wake_log {
+	__u64	events;		/* user pointer to struct gpio_misc_wake_event[] */
+	__u32	count;		/* in: room for records, out: records copied */
+	__u32	lost;		/* out: records overwritten since the last drain */
+};
+
+#define GPIO_MISC_IOC_GET_VERSION	_IOR(GPIO_MISC_IOC_MAGIC, 0x00, __u32)
+#define GPIO_MISC_IOC_SET_VALUES	_IOW(GPIO_MISC_IOC_MAGIC, 0x01, struct gpio_misc_line_values)
+#define GPIO_MISC_IOC_GET_VALUES	_IOWR(GPIO_MISC_IOC_MAGIC, 0x02, struct gpio_misc_line_values)
+#define GPIO_MISC_IOC_SET_DIRECTION	_IOW(GPIO_MISC_IOC_MAGIC, 0x03, struct gpio_misc_line_values)
+#define GPIO_MISC_IOC_GET_DIRECTION	_IOWR(GPIO_MISC_IOC_MAGIC, 0x04, struct gpio_misc_line_values)
+#define GPIO_MISC_IOC_WAVE_SUBMIT	_IOW(GPIO_MISC_IOC_MAGIC, 0x05, struct gpio_misc_wave)
+#define GPIO_MISC_IOC_WAVE_STOP		_IO(GPIO_MISC_IOC_MAGIC, 0x06)
+#define GPIO_MISC_IOC_WAVE_STATS	_IOR(GPIO_MISC_IOC_MAGIC, 0x07, struct gpio_misc_wave_stats)
+#define GPIO_MISC_IOC_CAPTURE		_IOWR(GPIO_MISC_IOC_MAGIC, 0x08, struct gpio_misc_capture)
+#define GPIO_MISC_IOC_CAPTURE_RESET	_IOW(GPIO_MISC_IOC_MAGIC, 0x09, __u32)
+#define GPIO_MISC_IOC_SAMPLER_START	_IOW(GPIO_MISC_IOC_MAGIC, 0x0a, struct gpio_misc_sampler)
+#define GPIO_MISC_IOC_SAMPLER_STOP	_IO(GPIO_MISC_IOC_MAGIC, 0x0b)
+#define GPIO_MISC_IOC_SET_FILTER	_IOWR(GPIO_MISC_IOC_MAGIC, 0x0c, struct gpio_misc_filter)
+#define GPIO_MISC_IOC_SET_WAKE		_IOWR(GPIO_MISC_IOC_MAGIC, 0x0d, struct gpio_misc_wake)
+#define GPIO_MISC_IOC_WAKE_EVENTS	_IOWR(GPIO_MISC_IOC_MAGIC, 0x0e, struct gpio_misc_wake_log)
+
+#endif
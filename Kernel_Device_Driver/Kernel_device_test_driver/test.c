@@ -1,30 +1,559 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 
+#include "gpio_misc_uapi.h"
+
+/*
+ * misc GPIO benchmark
+ *
+ *   test [-d node] [-a out_pin] [-b in_pin] [-n loops] [-l samples] [-s]
+ *   test -t threads [-d node] [-e node_b] [-a pin] [-b pin_b] [-n loops] [-s]
+ *
+ * Pin a must be wired to pin b, both managed by the same node. Results
+ * are printed as one JSON object on stdout. With -s the driver is
+ * replaced by an in-process register model, so the tool also runs on a
+ * host without the board.
+ *
+ * With -t the tool instead runs a register race stress: half of the
+ * threads flip the direction of pin a through node, the other half the
+ * direction of pin b through node_b (default node). Threads of the same
+ * pin take turns, so the two pins are always written concurrently and
+ * every write is read back; an update clobbered by the other pin shows
+ * as a mismatch. Both output latches are cleared first, so a wired pair
+ * never drives against itself.
+ */
+
 #define NODE_NAME "/dev/gpio_Alive"
-//#define NODE_NAME "/dev/gpio_Alive2"
-//#define NODE_NAME "/dev/gpio_Alive4"
- 
-int main(int argc, char * argv[])
+
+#define LOOPS       100000
+#define SAMPLES     10000
+#define EDGE_WAIT_MS 100
+
+#define SIM_EVENTS  64
+#define STRESS_MAX_THREADS 64
+
+struct bench {
+    int fd;
+    int sim;
+    unsigned int out_pin;
+    unsigned int in_pin;
+
+    /* simulated alive block, out_pin is wired to in_pin */
+    uint32_t sim_outenb;
+    uint32_t sim_out;
+    uint32_t sim_seq;
+    struct gpio_misc_event sim_events[SIM_EVENTS];
+    unsigned int sim_head;
+    unsigned int sim_tail;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t sim_pad(const struct bench *b)
+{
+    uint32_t pad = b->sim_out & b->sim_outenb;
+
+    if (pad & (1u << b->out_pin))
+        pad |= 1u << b->in_pin;
+    else
+        pad &= ~(1u << b->in_pin);
+    return pad;
+}
+
+static int sim_ioctl(struct bench *b, unsigned long cmd, void *arg)
+{
+    struct gpio_misc_line_values *lv = arg;
+    uint32_t before = sim_pad(b), changed;
+    struct gpio_misc_event *ev;
+
+    /* SET and RESET registers, each write only touches its own bits */
+    switch (cmd) {
+    case GPIO_MISC_IOC_GET_VERSION:
+        *(unsigned int *)arg = GPIO_MISC_ABI_VERSION;
+        return 0;
+    case GPIO_MISC_IOC_SET_VALUES:
+        __atomic_fetch_or(&b->sim_out, lv->bits & lv->mask, __ATOMIC_SEQ_CST);
+        __atomic_fetch_and(&b->sim_out, ~(~lv->bits & lv->mask),
+                           __ATOMIC_SEQ_CST);
+        break;
+    case GPIO_MISC_IOC_SET_DIRECTION:
+        __atomic_fetch_or(&b->sim_outenb, lv->bits & lv->mask,
+                          __ATOMIC_SEQ_CST);
+        __atomic_fetch_and(&b->sim_outenb, ~(~lv->bits & lv->mask),
+                           __ATOMIC_SEQ_CST);
+        break;
+    case GPIO_MISC_IOC_GET_VALUES:
+        lv->bits = sim_pad(b) & lv->mask;
+        return 0;
+    case GPIO_MISC_IOC_GET_DIRECTION:
+        lv->bits = b->sim_outenb & lv->mask;
+        return 0;
+    case GPIO_MISC_IOC_SET_FILTER:
+        ((struct gpio_misc_filter *)arg)->lost = 0;
+        return 0;
+    default:
+        return -1;
+    }
+
+    /* the input pin raises an event like the IRQ top half would */
+    changed = (before ^ sim_pad(b)) & (1u << b->in_pin);
+    if (changed && b->sim_head - b->sim_tail < SIM_EVENTS) {
+        ev = &b->sim_events[b->sim_head++ % SIM_EVENTS];
+        memset(ev, 0, sizeof(*ev));
+        ev->timestamp_ns = now_ns();
+        ev->seq = b->sim_seq++;
+        ev->pin = b->in_pin;
+        ev->edge = (sim_pad(b) & changed) ? GPIO_MISC_EDGE_RISING :
+                                            GPIO_MISC_EDGE_FALLING;
+    }
+    return 0;
+}
+
+static int dev_ioctl(struct bench *b, unsigned long cmd, void *arg)
+{
+    if (b->sim)
+        return sim_ioctl(b, cmd, arg);
+    return ioctl(b->fd, cmd, arg);
+}
+
+/* next event of the input pin, 0 on success, 1 on timeout */
+static int dev_wait_event(struct bench *b, struct gpio_misc_event *ev)
+{
+    struct pollfd pfd = { .fd = b->fd, .events = POLLIN };
+
+    if (b->sim) {
+        if (b->sim_head == b->sim_tail)
+            return 1;
+        *ev = b->sim_events[b->sim_tail++ % SIM_EVENTS];
+        return 0;
+    }
+
+    for (;;) {
+        if (read(b->fd, ev, sizeof(*ev)) == sizeof(*ev)) {
+            if (ev->pin == b->in_pin)
+                return 0;
+            continue;
+        }
+        if (poll(&pfd, 1, EDGE_WAIT_MS) <= 0)
+            return 1;
+    }
+}
+
+static void dev_drain_events(struct bench *b)
+{
+    struct gpio_misc_event ev;
+
+    if (b->sim) {
+        b->sim_tail = b->sim_head;
+        return;
+    }
+    while (read(b->fd, &ev, sizeof(ev)) == sizeof(ev))
+        ;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* nearest-rank percentile of sorted samples, p in per mille */
+static uint64_t percentile(const uint64_t *v, size_t n, unsigned int p)
+{
+    size_t rank = (n * p + 999) / 1000;
+
+    return n ? v[rank ? rank - 1 : 0] : 0;
+}
+
+static void print_dist(const char *name, uint64_t *v, size_t n, int last)
+{
+    uint64_t sum = 0;
+    size_t i;
+
+    qsort(v, n, sizeof(*v), cmp_u64);
+    for (i = 0; i < n; i++)
+        sum += v[i];
+
+    printf("    \"%s\": {\"samples\": %zu, \"min\": %llu, \"avg\": %llu, "
+           "\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}%s\n",
+           name, n,
+           (unsigned long long)(n ? v[0] : 0),
+           (unsigned long long)(n ? sum / n : 0),
+           (unsigned long long)percentile(v, n, 500),
+           (unsigned long long)percentile(v, n, 990),
+           (unsigned long long)percentile(v, n, 999),
+           (unsigned long long)(n ? v[n - 1] : 0),
+           last ? "" : ",");
+}
+
+/* syscall round trip of the cheapest ioctl */
+static int bench_roundtrip(struct bench *b, uint64_t *v, size_t n)
+{
+    unsigned int version;
+    uint64_t start;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        start = now_ns();
+        if (dev_ioctl(b, GPIO_MISC_IOC_GET_VERSION, &version) < 0)
+            return -1;
+        v[i] = now_ns() - start;
+    }
+    return 0;
+}
+
+/* masked set/get throughput through the multi-pin ioctl ABI */
+static int bench_throughput(struct bench *b, unsigned int loops,
+                            double *set_ops, double *get_ops)
+{
+    struct gpio_misc_line_values lv = { 0 };
+    uint64_t start;
+    unsigned int i;
+
+    lv.mask = 1u << b->out_pin;
+
+    start = now_ns();
+    for (i = 0; i < loops; i++) {
+        lv.bits = (i & 1) ? lv.mask : 0;
+        if (dev_ioctl(b, GPIO_MISC_IOC_SET_VALUES, &lv) < 0)
+            return -1;
+    }
+    *set_ops = loops * 1e9 / (now_ns() - start);
+
+    start = now_ns();
+    for (i = 0; i < loops; i++) {
+        if (dev_ioctl(b, GPIO_MISC_IOC_GET_VALUES, &lv) < 0)
+            return -1;
+    }
+    *get_ops = loops * 1e9 / (now_ns() - start);
+
+    return 0;
+}
+
+/*
+ * toggle the output pin and wait for the input pin event, edge is the
+ * kernel timestamp of the edge, wake is when read() handed it to us
+ */
+static int bench_loopback(struct bench *b, uint64_t *edge, uint64_t *wake,
+                          size_t n, size_t *got, unsigned int *lost)
 {
+    struct gpio_misc_line_values lv = { 0 };
+    struct gpio_misc_event ev;
+    uint64_t start;
+    size_t i;
+
+    lv.mask = 1u << b->out_pin;
+    lv.bits = 0;
+    if (dev_ioctl(b, GPIO_MISC_IOC_SET_VALUES, &lv) < 0)
+        return -1;
+    usleep(1000);
+    dev_drain_events(b);
+
+    *got = 0;
+    *lost = 0;
+    for (i = 0; i < n; i++) {
+        lv.bits ^= lv.mask;
+
+        start = now_ns();
+        if (dev_ioctl(b, GPIO_MISC_IOC_SET_VALUES, &lv) < 0)
+            return -1;
+        if (dev_wait_event(b, &ev)) {
+            (*lost)++;
+            continue;
+        }
+        wake[*got] = now_ns() - start;
+        edge[*got] = ev.timestamp_ns > start ? ev.timestamp_ns - start : 0;
+        (*got)++;
+    }
+    return 0;
+}
+
+/* writers of one pin, they take turns under lock */
+struct stress_pin {
+    pthread_mutex_t lock;
+    uint32_t mask;
+    uint32_t dir;       /* last direction written */
+};
+
+struct stress_thread {
+    pthread_t thread;
+    struct bench *b;
+    struct stress_pin *pin;
     int fd;
-    char dev_name[60];
-    for(int i = 0; i<= 1; i++)
-    {
-        sprintf(dev_name, "%s%d", NODE_NAME, (i+1)*2);
-        fd = open(dev_name, O_RDWR);
-
-        if(fd < 0) {
-            printf("%s Device open error\n", dev_name);
+    unsigned int loops;
+    unsigned int errors;
+    unsigned int mismatches;
+};
+
+static int stress_ioctl(struct stress_thread *t, unsigned long cmd, void *arg)
+{
+    if (t->b->sim)
+        return sim_ioctl(t->b, cmd, arg);
+    return ioctl(t->fd, cmd, arg);
+}
+
+static void *stress_fn(void *arg)
+{
+    struct stress_thread *t = arg;
+    struct stress_pin *pin = t->pin;
+    struct gpio_misc_line_values lv = { 0 };
+    unsigned int i;
+
+    lv.mask = pin->mask;
+    /* the pin must still hold our last write, then take the next one */
+    for (i = 0; i < t->loops; i++) {
+        pthread_mutex_lock(&pin->lock);
+        if (stress_ioctl(t, GPIO_MISC_IOC_GET_DIRECTION, &lv) < 0)
+            t->errors++;
+        else if (lv.bits != pin->dir)
+            t->mismatches++;
+
+        pin->dir ^= pin->mask;
+        lv.bits = pin->dir;
+        if (stress_ioctl(t, GPIO_MISC_IOC_SET_DIRECTION, &lv) < 0 ||
+            stress_ioctl(t, GPIO_MISC_IOC_GET_DIRECTION, &lv) < 0)
+            t->errors++;
+        else if (lv.bits != pin->dir)
+            t->mismatches++;
+        pthread_mutex_unlock(&pin->lock);
+    }
+    return NULL;
+}
+
+static int run_stress(struct bench *b, int fd_b, unsigned int nthreads,
+                      unsigned int loops)
+{
+    struct stress_thread t[STRESS_MAX_THREADS];
+    struct stress_pin pins[2];
+    struct gpio_misc_line_values lv = { 0 };
+    unsigned int i, errors = 0, mismatches = 0, ok = 1;
+    uint64_t start, elapsed;
+
+    for (i = 0; i < 2; i++) {
+        pthread_mutex_init(&pins[i].lock, NULL);
+        pins[i].mask = 1u << (i ? b->in_pin : b->out_pin);
+        pins[i].dir = 0;
+    }
+
+    for (i = 0; i < nthreads; i++) {
+        memset(&t[i], 0, sizeof(t[i]));
+        t[i].b = b;
+        t[i].pin = &pins[i & 1];
+        t[i].fd = (i & 1) ? fd_b : b->fd;
+        t[i].loops = loops;
+    }
+
+    /* latches low first, then start both pins as inputs */
+    for (i = 0; i < 2; i++) {
+        lv.mask = pins[i].mask;
+        lv.bits = 0;
+        if (stress_ioctl(&t[i], GPIO_MISC_IOC_SET_VALUES, &lv) < 0 ||
+            stress_ioctl(&t[i], GPIO_MISC_IOC_SET_DIRECTION, &lv) < 0)
             return -1;
+    }
+
+    start = now_ns();
+    for (i = 0; i < nthreads; i++) {
+        if (pthread_create(&t[i].thread, NULL, stress_fn, &t[i])) {
+            nthreads = i;
+            ok = 0;
+            break;
+        }
+    }
+    for (i = 0; i < nthreads; i++)
+        pthread_join(t[i].thread, NULL);
+    elapsed = now_ns() - start;
+
+    printf("{\n  \"stress\": {\"threads\": %u, \"loops\": %u, "
+           "\"ns_per_op\": %.1f,\n", nthreads, loops,
+           nthreads ? (double)elapsed / ((uint64_t)nthreads * loops) : 0.0);
+
+    /* the final state must be the last write of each pin */
+    for (i = 0; i < 2; i++) {
+        lv.mask = pins[i].mask;
+        if (stress_ioctl(&t[i], GPIO_MISC_IOC_GET_DIRECTION, &lv) < 0)
+            lv.bits = ~pins[i].dir & lv.mask;
+        printf("    \"pin_%u\": {\"expected\": \"%s\", \"got\": \"%s\"},\n",
+               i ? b->in_pin : b->out_pin,
+               pins[i].dir ? "out" : "in", lv.bits ? "out" : "in");
+        ok &= lv.bits == pins[i].dir;
+
+        /* leave the pin as an input */
+        lv.bits = 0;
+        stress_ioctl(&t[i], GPIO_MISC_IOC_SET_DIRECTION, &lv);
+        pthread_mutex_destroy(&pins[i].lock);
+    }
+    for (i = 0; i < nthreads; i++) {
+        errors += t[i].errors;
+        mismatches += t[i].mismatches;
+    }
+    ok &= !errors && !mismatches;
+
+    printf("    \"ioctl_errors\": %u,\n    \"readback_mismatches\": %u,\n"
+           "    \"result\": \"%s\"\n  }\n}\n",
+           errors, mismatches, ok ? "pass" : "fail");
+    return ok ? 0 : 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d node] [-a out_pin] [-b in_pin] [-n loops] "
+            "[-l samples] [-s]\n"
+            "       %s -t threads [-d node] [-e node_b] [-a pin] [-b pin_b] "
+            "[-n loops] [-s]\n"
+            "  -d  device node (default %s)\n"
+            "  -e  node of pin b for -t (default the -d node)\n"
+            "  -a  output pin driving the loopback (default 2)\n"
+            "  -b  input pin wired to the output pin (default 4)\n"
+            "  -n  set/get throughput loops (default %d)\n"
+            "  -l  round trip and loopback samples (default %d)\n"
+            "  -s  simulated registers, no device needed\n"
+            "  -t  race stress with this many threads instead of benchmarks\n",
+            prog, prog, NODE_NAME, LOOPS, SAMPLES);
+}
+
+int main(int argc, char * argv[])
+{
+    struct bench *b;
+    struct gpio_misc_line_values lv = { 0 };
+    struct gpio_misc_filter filter = { 0 };
+    const char *dev_name = NODE_NAME, *node_b = NULL;
+    unsigned int loops = LOOPS, samples = SAMPLES, version = 0, lost;
+    unsigned int threads = 0;
+    int fd_b = -1;
+    uint64_t *rtt, *edge, *wake;
+    double set_ops, get_ops;
+    size_t got;
+    int opt, ret = 1;
+
+    b = calloc(1, sizeof(*b));
+    if (!b)
+        return 1;
+    b->fd = -1;
+    b->out_pin = 2;
+    b->in_pin = 4;
+
+    while ((opt = getopt(argc, argv, "d:e:a:b:n:l:st:h")) != -1) {
+        switch (opt) {
+        case 'd': dev_name = optarg; break;
+        case 'e': node_b = optarg; break;
+        case 'a': b->out_pin = strtoul(optarg, NULL, 0); break;
+        case 'b': b->in_pin = strtoul(optarg, NULL, 0); break;
+        case 'n': loops = strtoul(optarg, NULL, 0); break;
+        case 'l': samples = strtoul(optarg, NULL, 0); break;
+        case 's': b->sim = 1; break;
+        case 't': threads = strtoul(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return 1;
         }
+    }
 
-        read(fd, NULL, 0);
-        write(fd, NULL, 0);
-        ioctl(fd, 0, NULL);
-        close(fd);
+    if (b->out_pin > 31 || b->in_pin > 31 || b->out_pin == b->in_pin ||
+        !loops || !samples || threads == 1 || threads > STRESS_MAX_THREADS) {
+        usage(argv[0]);
+        return 1;
     }
+
+    rtt = calloc(samples, sizeof(*rtt));
+    edge = calloc(samples, sizeof(*edge));
+    wake = calloc(samples, sizeof(*wake));
+    if (!rtt || !edge || !wake)
+        goto out;
+
+    if (!b->sim) {
+        b->fd = open(dev_name, O_RDWR | O_NONBLOCK);
+        if (b->fd < 0) {
+            fprintf(stderr, "%s Device open error\n", dev_name);
+            goto out;
+        }
+    }
+
+    if (dev_ioctl(b, GPIO_MISC_IOC_GET_VERSION, &version) < 0 ||
+        version != GPIO_MISC_ABI_VERSION) {
+        fprintf(stderr, "%s ABI version %u, expected %u\n", dev_name,
+                version, GPIO_MISC_ABI_VERSION);
+        goto out;
+    }
+
+    if (threads) {
+        fd_b = b->fd;
+        if (node_b && !b->sim) {
+            fd_b = open(node_b, O_RDWR | O_NONBLOCK);
+            if (fd_b < 0) {
+                fprintf(stderr, "%s Device open error\n", node_b);
+                goto out;
+            }
+        }
+        ret = run_stress(b, fd_b, threads, loops);
+        goto out;
+    }
+
+    /* our queue only takes the loopback input, other openers keep theirs */
+    filter.pins = 1u << b->in_pin;
+    filter.edges = GPIO_MISC_EDGE_MASK(GPIO_MISC_EDGE_FALLING) |
+                   GPIO_MISC_EDGE_MASK(GPIO_MISC_EDGE_RISING);
+    if (dev_ioctl(b, GPIO_MISC_IOC_SET_FILTER, &filter) < 0) {
+        fprintf(stderr, "%s set filter error\n", dev_name);
+        goto out;
+    }
+
+    lv.mask = (1u << b->out_pin) | (1u << b->in_pin);
+    lv.bits = 1u << b->out_pin;
+    if (dev_ioctl(b, GPIO_MISC_IOC_SET_DIRECTION, &lv) < 0) {
+        fprintf(stderr, "%s set direction error\n", dev_name);
+        goto out;
+    }
+
+    if (bench_roundtrip(b, rtt, samples) < 0 ||
+        bench_throughput(b, loops, &set_ops, &get_ops) < 0 ||
+        bench_loopback(b, edge, wake, samples, &got, &lost) < 0) {
+        fprintf(stderr, "%s ioctl error\n", dev_name);
+        goto out_dir;
+    }
+
+    printf("{\n");
+    printf("  \"device\": \"%s\",\n", b->sim ? "sim" : dev_name);
+    printf("  \"abi_version\": %u,\n", version);
+    printf("  \"out_pin\": %u,\n  \"in_pin\": %u,\n", b->out_pin, b->in_pin);
+    printf("  \"throughput_ops_per_sec\": {\"loops\": %u, \"set\": %.0f, "
+           "\"get\": %.0f},\n", loops, set_ops, get_ops);
+    printf("  \"latency_ns\": {\n");
+    print_dist("ioctl_roundtrip", rtt, samples, 0);
+    print_dist("loopback_edge", edge, got, 0);
+    print_dist("loopback_wakeup", wake, got, 1);
+    printf("  },\n");
+    printf("  \"loopback_lost\": %u\n", lost);
+    printf("}\n");
+    ret = 0;
+
+out_dir:
+    lv.bits = 0;
+    dev_ioctl(b, GPIO_MISC_IOC_SET_DIRECTION, &lv);
+out:
+    if (fd_b >= 0 && fd_b != b->fd)
+        close(fd_b);
+    if (b->fd >= 0)
+        close(b->fd);
+    free(rtt);
+    free(edge);
+    free(wake);
+    free(b);
+    return ret;
 }
@@ -0,0 +1,90 @@
+/*
+ * Per-pin hrtimer debounce, see debounce.h. Linked into each test module
+ * that uses it, so every module has its own debugfs directory.
+ */
+#include <linux/debugfs.h>
+#include <linux/gpio.h>
+#include <linux/kernel.h>
+
+#include "debounce.h"
+
+static struct dentry *debounce_dir;
+
+/* window expired without new edges: sample the pad and decide */
+static enum hrtimer_restart debounce_timer_fn(struct hrtimer *timer)
+{
+	struct debounce_pin *pin = container_of(timer, struct debounce_pin,
+						timer);
+
+	spin_lock(&pin->lock);
+
+	/* re-armed by an edge on another CPU, the next expiry decides */
+	if (hrtimer_is_queued(timer)) {
+		spin_unlock(&pin->lock);
+		return HRTIMER_NORESTART;
+	}
+
+	pin->settling = false;
+	if (gpio_get_value(pin->gpio) == pin->active_level) {
+		pin->accepted++;
+		irq_wake_thread(pin->irq, pin);
+	} else {
+		pin->rejected++;
+	}
+
+	spin_unlock(&pin->lock);
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Count the bounce and push the window out, nothing else in hard IRQ. No
+ * logging here, a bouncing contact fires this many times per press.
+ */
+irqreturn_t debounce_edge(struct debounce_pin *pin)
+{
+	u64 window_ns = (u64)READ_ONCE(pin->window_us) * NSEC_PER_USEC;
+
+	spin_lock(&pin->lock);
+	if (pin->settling)
+		pin->rejected++;
+	pin->settling = true;
+	hrtimer_start(&pin->timer, ns_to_ktime(window_ns), HRTIMER_MODE_REL);
+	spin_unlock(&pin->lock);
+
+	/* the debounce timer wakes the thread once the level has settled */
+	return IRQ_HANDLED;
+}
+
+void debounce_init(const char *name, struct debounce_pin *pins,
+		   unsigned int npins, unsigned int irq)
+{
+	char dir[16];
+	unsigned int i;
+
+	debounce_dir = debugfs_create_dir(name, NULL);
+
+	for (i = 0; i < npins; i++) {
+		struct debounce_pin *pin = &pins[i];
+
+		pin->irq = irq;
+		spin_lock_init(&pin->lock);
+		hrtimer_init(&pin->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		pin->timer.function = debounce_timer_fn;
+
+		snprintf(dir, sizeof(dir), "gpio%u", pin->gpio);
+		pin->dir = debugfs_create_dir(dir, debounce_dir);
+		debugfs_create_u32("window_us", 0644, pin->dir,
+				   &pin->window_us);
+		debugfs_create_u32("accepted", 0444, pin->dir, &pin->accepted);
+		debugfs_create_u32("rejected", 0444, pin->dir, &pin->rejected);
+	}
+}
+
+void debounce_exit(struct debounce_pin *pins, unsigned int npins)
+{
+	unsigned int i;
+
+	debugfs_remove_recursive(debounce_dir);
+	for (i = 0; i < npins; i++)
+		hrtimer_cancel(&pins[i].timer);
+}
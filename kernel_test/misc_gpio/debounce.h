@@ -0,0 +1,39 @@
+/*
+ * Per-pin hrtimer debounce shared by the misc_gpio and threadedirq test
+ * modules. The first edge arms an hrtimer, every further edge inside the
+ * window counts as a bounce and restarts it. When the window closes
+ * quietly the pad is sampled once: the active level wakes the IRQ
+ * thread, anything else was a glitch.
+ */
+#ifndef __DEBOUNCE_H__
+#define __DEBOUNCE_H__
+
+#include <linux/hrtimer.h>
+#include <linux/interrupt.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+
+struct dentry;
+
+struct debounce_pin {
+	unsigned int gpio;
+	unsigned int irq;
+	int active_level;	/* level the trigger edge leads to */
+	u32 window_us;		/* debugfs writable, read with READ_ONCE */
+	bool settling;
+	spinlock_t lock;
+	struct hrtimer timer;
+	u32 accepted;
+	u32 rejected;
+	struct dentry *dir;
+};
+
+/* top half, pin is the IRQ dev_id */
+irqreturn_t debounce_edge(struct debounce_pin *pin);
+
+/* counters and the window live under /sys/kernel/debug/<name>/gpioN/ */
+void debounce_init(const char *name, struct debounce_pin *pins,
+		   unsigned int npins, unsigned int irq);
+void debounce_exit(struct debounce_pin *pins, unsigned int npins);
+
+#endif /* __DEBOUNCE_H__ */
@@ -26,6 +26,7 @@
 #include <linux/spinlock.h>
 #include <linux/syscore_ops.h>
 #include <linux/of_irq.h>
+#include <linux/version.h>
 
 #include "../core.h"
 #include "s5pxx18-gpio.h"
@@ -575,6 +576,28 @@ static int nx_gpio_get(struct gpio_chip *gc, unsigned offset)
 	return data;
 }
 
+/* gpiolib gpio_set_multiple callback, one register update per bank */
+static void nx_gpio_set_multiple(struct gpio_chip *gc, unsigned long *mask,
+				 unsigned long *bits)
+{
+	struct nexell_pin_bank *bank = gc_to_pin_bank(gc);
+
+	nx_soc_gpio_set_out_values(bank->grange.pin_base, *mask, *bits);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+/* gpiolib gpio_get_multiple callback, one pad register read per bank */
+static int nx_gpio_get_multiple(struct gpio_chip *gc, unsigned long *mask,
+				unsigned long *bits)
+{
+	struct nexell_pin_bank *bank = gc_to_pin_bank(gc);
+	u32 pad = nx_soc_gpio_get_in_values(bank->grange.pin_base);
+
+	*bits = (*bits & ~*mask) | (pad & *mask);
+	return 0;
+}
+#endif
+
 /*
  * The calls to gpio_direction_output() and gpio_direction_input()
  * leads to this function call.
@@ -916,6 +939,10 @@ static const struct gpio_chip nexell_gpiolib_chip = {
 	.free = nx_gpio_free,
 	.set = nx_gpio_set,
 	.get = nx_gpio_get,
+	.set_multiple = nx_gpio_set_multiple,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+	.get_multiple = nx_gpio_get_multiple,
+#endif
 	.direction_input = nx_gpio_direction_input,
 	.direction_output = nx_gpio_direction_output,
 	.to_irq = nx_gpio_to_irq,
@@ -1001,7 +1028,7 @@ nexell_pinctrl_get_soc_data(struct nexell_pinctrl_drv_data *d,
 
 	bank = ctrl->pin_banks;
 	for (i = 0; i < ctrl->nr_banks; ++i, ++bank) {
-		spin_lock_init(&bank->slock);
+		raw_spin_lock_init(&bank->slock);
 		bank->drvdata = d;
 		bank->pin_base = ctrl->nr_pins;
 		ctrl->nr_pins += bank->nr_pins;
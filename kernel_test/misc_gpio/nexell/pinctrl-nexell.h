@@ -110,7 +110,12 @@ struct nexell_pinctrl_drv_data;
  * @irq_domain: IRQ domain of the bank.
  * @gpio_chip: GPIO chip of the bank.
  * @grange: linux gpio pin range supported by this bank.
- * @slock: spinlock protecting bank registers
+ * @slock: raw spinlock protecting read-modify-write of bank registers
+ * @irq_unknown: parent irq entries that found no enabled pin pending.
+ * @irq_spurious: enabled pending pins that had no irq mapped.
+ * @lock_acquired: slock acquisitions (CONFIG_PINCTRL_NEXELL_LOCK_STAT).
+ * @lock_contended: acquisitions that had to wait for another holder.
+ * @lock_wait_ns: total time spent waiting for slock.
  */
 struct nexell_pin_bank {
 	u32		pctl_offset;
@@ -129,7 +134,14 @@ struct nexell_pin_bank {
 	struct gpio_chip gpio_chip;
 	struct pinctrl_gpio_range grange;
 	struct nexell_irq_chip *irq_chip;
-	spinlock_t slock;
+	raw_spinlock_t	slock;
+	u32		irq_unknown;
+	u32		irq_spurious;
+#ifdef CONFIG_PINCTRL_NEXELL_LOCK_STAT
+	u32		lock_acquired;
+	u32		lock_contended;
+	u64		lock_wait_ns;
+#endif
 };
 
 /**
@@ -30,6 +30,8 @@
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/err.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "pinctrl-nexell.h"
 #include "pinctrl-s5pxx18.h"
@@ -54,9 +56,16 @@
 	case PAD_GPIO_H
 #endif
 
+/*
+ * gpio_shadow holds what was last written to each writable config and
+ * interrupt register of the bank (out, direction, function, pull, drive,
+ * slew, detect). It is read once at nx_gpio_open_module, then every
+ * setter modifies the shadow and writes the register without reading it
+ * back, and suspend has nothing left to save. Writers hold the bank lock.
+ */
 static struct {
 	struct nx_gpio_reg_set *gpio_regs;
-	struct nx_gpio_reg_set gpio_save;
+	struct nx_gpio_reg_set gpio_shadow;
 } gpio_modules[NUMBER_OF_GPIO_MODULE];
 
 static struct nx_alive_reg_set *alive_regs;
@@ -66,41 +75,83 @@ static struct nx_alive_reg_set alive_saves;
  * gpio functions
  */
 
-void nx_gpio_setbit(u32 *p, u32 bit, bool enable)
+bool nx_gpio_getbit(u32 value, u32 bit)
 {
-	u32 newvalue = readl(p);
+	return (bool)((value >> bit) & (1UL));
+}
 
-	newvalue &= ~(1UL << bit);
-	newvalue |= (u32)enable << bit;
+u32 nx_gpio_getbit2(u32 value, u32 bit)
+{
+	return (u32)((u32)(value >> (bit * 2)) & 3UL);
+}
 
-	writel(newvalue, p);
+/* shadow copy of the bank register p points to */
+static inline u32 *nx_gpio_shadow(u32 idx, u32 *p)
+{
+	return (u32 *)((char *)&gpio_modules[idx].gpio_shadow +
+		       ((char *)p - (char *)gpio_modules[idx].gpio_regs));
 }
 
-bool nx_gpio_getbit(u32 value, u32 bit)
+static void nx_gpio_shadow_write(u32 idx, u32 *p, u32 value)
 {
-	return (bool)((value >> bit) & (1UL));
+	u32 *shadow = nx_gpio_shadow(idx, p);
+
+	if (*shadow == value)
+		return;
+
+	*shadow = value;
+	writel(value, p);
 }
 
-void nx_gpio_setbit2(u32 *p, u32 bit, u32 value)
+static void nx_gpio_shadow_setbit(u32 idx, u32 *p, u32 bit, bool enable)
 {
-	u32 newvalue = readl(p);
+	u32 newvalue = *nx_gpio_shadow(idx, p);
 
-	newvalue = (u32)(newvalue & ~(3UL << (bit * 2)));
-	newvalue = (u32)(newvalue | (value << (bit * 2)));
+	newvalue &= ~(1UL << bit);
+	newvalue |= (u32)enable << bit;
 
-	writel(newvalue, p);
+	nx_gpio_shadow_write(idx, p, newvalue);
 }
 
-u32 nx_gpio_getbit2(u32 value, u32 bit)
+static void nx_gpio_shadow_setbit2(u32 idx, u32 *p, u32 bit, u32 value)
 {
-	return (u32)((u32)(value >> (bit * 2)) & 3UL);
+	u32 newvalue = *nx_gpio_shadow(idx, p);
+
+	newvalue = (u32)(newvalue & ~(3UL << (bit * 2)));
+	newvalue = (u32)(newvalue | (value << (bit * 2)));
+
+	nx_gpio_shadow_write(idx, p, newvalue);
 }
 
 bool nx_gpio_open_module(u32 idx)
 {
 	struct nx_gpio_reg_set *p_register;
+	struct nx_gpio_reg_set *shadow;
 
 	p_register = gpio_modules[idx].gpio_regs;
+	shadow = &gpio_modules[idx].gpio_shadow;
+
+	/* the one time the config registers are read back */
+	shadow->GPIOxOUT = readl(&p_register->GPIOxOUT);
+	shadow->GPIOxOUTENB = readl(&p_register->GPIOxOUTENB);
+	shadow->GPIOxDETMODE[0] = readl(&p_register->GPIOxDETMODE[0]);
+	shadow->GPIOxDETMODE[1] = readl(&p_register->GPIOxDETMODE[1]);
+	shadow->GPIOxINTENB = readl(&p_register->GPIOxINTENB);
+	shadow->GPIOxALTFN[0] = readl(&p_register->GPIOxALTFN[0]);
+	shadow->GPIOxALTFN[1] = readl(&p_register->GPIOxALTFN[1]);
+	shadow->GPIOxDETMODEEX = readl(&p_register->GPIOxDETMODEEX);
+	shadow->GPIOxDETENB = readl(&p_register->GPIOxDETENB);
+	shadow->GPIOx_SLEW = readl(&p_register->GPIOx_SLEW);
+	shadow->GPIOx_DRV1 = readl(&p_register->GPIOx_DRV1);
+	shadow->GPIOx_DRV0 = readl(&p_register->GPIOx_DRV0);
+	shadow->GPIOx_PULLSEL = readl(&p_register->GPIOx_PULLSEL);
+	shadow->GPIOx_PULLENB = readl(&p_register->GPIOx_PULLENB);
+
+	shadow->GPIOx_SLEW_DISABLE_DEFAULT = 0xFFFFFFFF;
+	shadow->GPIOx_DRV1_DISABLE_DEFAULT = 0xFFFFFFFF;
+	shadow->GPIOx_DRV0_DISABLE_DEFAULT = 0xFFFFFFFF;
+	shadow->GPIOx_PULLSEL_DISABLE_DEFAULT = 0xFFFFFFFF;
+	shadow->GPIOx_PULLENB_DISABLE_DEFAULT = 0xFFFFFFFF;
 
 	writel(0xFFFFFFFF, &p_register->GPIOx_SLEW_DISABLE_DEFAULT);
 	writel(0xFFFFFFFF, &p_register->GPIOx_DRV1_DISABLE_DEFAULT);
@@ -117,7 +168,7 @@ void nx_gpio_set_output_enable(u32 idx, u32 bitnum, bool enable)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOxOUTENB, bitnum, enable);
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOxOUTENB, bitnum, enable);
 }
 
 bool nx_gpio_get_detect_enable(u32 idx, u32 bitnum)
@@ -135,7 +186,7 @@ void nx_gpio_set_detect_enable(u32 idx, u32 bitnum, bool enable)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOxDETENB, bitnum, enable);
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOxDETENB, bitnum, enable);
 }
 
 bool nx_gpio_get_output_enable(u32 idx, u32 bitnum)
@@ -153,7 +204,7 @@ void nx_gpio_set_output_value(u32 idx, u32 bitnum, bool value)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOxOUT, bitnum, value);
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOxOUT, bitnum, value);
 }
 
 bool nx_gpio_get_output_value(u32 idx, u32 bitnum)
@@ -174,12 +225,34 @@ bool nx_gpio_get_input_value(u32 idx, u32 bitnum)
 	return nx_gpio_getbit(readl(&p_register->GPIOxPAD), bitnum);
 }
 
+void nx_gpio_set_output_values(u32 idx, u32 mask, u32 values)
+{
+	struct nx_gpio_reg_set *p_register;
+	u32 newvalue;
+
+	p_register = gpio_modules[idx].gpio_regs;
+
+	newvalue = gpio_modules[idx].gpio_shadow.GPIOxOUT;
+	newvalue = (newvalue & ~mask) | (values & mask);
+	nx_gpio_shadow_write(idx, &p_register->GPIOxOUT, newvalue);
+}
+
+u32 nx_gpio_get_input_values(u32 idx)
+{
+	struct nx_gpio_reg_set *p_register;
+
+	p_register = gpio_modules[idx].gpio_regs;
+
+	return readl(&p_register->GPIOxPAD);
+}
+
 void nx_gpio_set_pull_select(u32 idx, u32 bitnum, bool enable)
 {
-	nx_gpio_setbit(
-	    &gpio_modules[idx].gpio_regs->GPIOx_PULLSEL_DISABLE_DEFAULT,
-	    bitnum, true);
-	nx_gpio_setbit(&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL, bitnum,
+	nx_gpio_shadow_setbit(idx,
+		&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL_DISABLE_DEFAULT,
+		bitnum, true);
+	nx_gpio_shadow_setbit(idx,
+	    &gpio_modules[idx].gpio_regs->GPIOx_PULLSEL, bitnum,
 		       enable);
 }
 
@@ -191,23 +264,27 @@ bool nx_gpio_get_pull_select(u32 idx, u32 bitnum)
 
 void nx_gpio_set_pull_mode(u32 idx, u32 bitnum, int mode)
 {
-	nx_gpio_setbit(
-	    &gpio_modules[idx].gpio_regs->GPIOx_PULLSEL_DISABLE_DEFAULT,
-	    bitnum, true);
-	nx_gpio_setbit(
-	    &gpio_modules[idx].gpio_regs->GPIOx_PULLENB_DISABLE_DEFAULT,
-	    bitnum, true);
+	nx_gpio_shadow_setbit(idx,
+		&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL_DISABLE_DEFAULT,
+		bitnum, true);
+	nx_gpio_shadow_setbit(idx,
+		&gpio_modules[idx].gpio_regs->GPIOx_PULLENB_DISABLE_DEFAULT,
+		bitnum, true);
 
 	if (mode == nx_gpio_pull_off) {
-		nx_gpio_setbit(&gpio_modules[idx].gpio_regs->GPIOx_PULLENB,
-			       bitnum, false);
-		nx_gpio_setbit(&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL,
-			       bitnum, false);
+		nx_gpio_shadow_setbit(idx,
+			&gpio_modules[idx].gpio_regs->GPIOx_PULLENB, bitnum,
+			false);
+		nx_gpio_shadow_setbit(idx,
+			&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL, bitnum,
+			false);
 	} else {
-		nx_gpio_setbit(&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL,
-			       bitnum, (mode & 1 ? true : false));
-		nx_gpio_setbit(&gpio_modules[idx].gpio_regs->GPIOx_PULLENB,
-			       bitnum, true);
+		nx_gpio_shadow_setbit(idx,
+			&gpio_modules[idx].gpio_regs->GPIOx_PULLSEL, bitnum,
+			(mode & 1 ? true : false));
+		nx_gpio_shadow_setbit(idx,
+			&gpio_modules[idx].gpio_regs->GPIOx_PULLENB, bitnum,
+			true);
 	}
 }
 
@@ -217,8 +294,8 @@ void nx_gpio_set_pad_function(u32 idx, u32 bitnum, int padfunc)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit2(&p_register->GPIOxALTFN[bitnum / 16], bitnum % 16,
-			(u32)padfunc);
+	nx_gpio_shadow_setbit2(idx, &p_register->GPIOxALTFN[bitnum / 16],
+			       bitnum % 16, (u32)padfunc);
 }
 
 int nx_gpio_get_pad_function(u32 idx, u32 bitnum)
@@ -237,7 +314,7 @@ void nx_gpio_set_slew(u32 idx, u32 bitnum, bool enable)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOx_SLEW, bitnum, enable);
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOx_SLEW, bitnum, enable);
 }
 
 void nx_gpio_set_slew_disable_default(u32 idx, u32 bitnum, bool enable)
@@ -246,8 +323,8 @@ void nx_gpio_set_slew_disable_default(u32 idx, u32 bitnum, bool enable)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOx_SLEW_DISABLE_DEFAULT, bitnum,
-		       enable);
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOx_SLEW_DISABLE_DEFAULT,
+			      bitnum, enable);
 }
 
 bool nx_gpio_get_slew(u32 idx, u32 bitnum)
@@ -265,10 +342,10 @@ void nx_gpio_set_drive_strength(u32 idx, u32 bitnum, int drvstrength)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOx_DRV1, bitnum,
-		       (bool)(((u32)drvstrength >> 0) & 0x1));
-	nx_gpio_setbit(&p_register->GPIOx_DRV0, bitnum,
-		       (bool)(((u32)drvstrength >> 1) & 0x1));
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOx_DRV1, bitnum,
+			      (bool)(((u32)drvstrength >> 0) & 0x1));
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOx_DRV0, bitnum,
+			      (bool)(((u32)drvstrength >> 1) & 0x1));
 }
 
 void nx_gpio_set_drive_strength_disable_default(u32 idx, u32 bitnum,
@@ -278,10 +355,10 @@ void nx_gpio_set_drive_strength_disable_default(u32 idx, u32 bitnum,
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit(&p_register->GPIOx_DRV1_DISABLE_DEFAULT, bitnum,
-		       (bool)(enable));
-	nx_gpio_setbit(&p_register->GPIOx_DRV0_DISABLE_DEFAULT, bitnum,
-		       (bool)(enable));
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOx_DRV1_DISABLE_DEFAULT,
+			      bitnum, (bool)(enable));
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOx_DRV0_DISABLE_DEFAULT,
+			      bitnum, (bool)(enable));
 }
 
 int nx_gpio_get_drive_strength(u32 idx, u32 bitnum)
@@ -306,11 +383,13 @@ void nx_gpio_set_pull_enable(u32 idx, u32 bitnum, int pullsel)
 	p_register = gpio_modules[idx].gpio_regs;
 
 	if (pullsel == nx_gpio_pull_down || pullsel == nx_gpio_pull_up) {
-		nx_gpio_setbit(&p_register->GPIOx_PULLSEL, bitnum,
-			       (bool)pullsel);
-		nx_gpio_setbit(&p_register->GPIOx_PULLENB, bitnum, true);
+		nx_gpio_shadow_setbit(idx, &p_register->GPIOx_PULLSEL, bitnum,
+				      (bool)pullsel);
+		nx_gpio_shadow_setbit(idx, &p_register->GPIOx_PULLENB, bitnum,
+				      true);
 	} else
-		nx_gpio_setbit(&p_register->GPIOx_PULLENB, bitnum, false);
+		nx_gpio_shadow_setbit(idx, &p_register->GPIOx_PULLENB, bitnum,
+				      false);
 }
 
 int nx_gpio_get_pull_enable(u32 idx, u32 bitnum)
@@ -347,12 +426,12 @@ void nx_gpio_set_interrupt_enable(u32 idx, s32 irqnum, bool enable)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	ReadValue = readl(&p_register->GPIOxINTENB);
+	ReadValue = gpio_modules[idx].gpio_shadow.GPIOxINTENB;
 
 	ReadValue &= ~((u32)1 << irqnum);
 	ReadValue |= ((u32)enable << irqnum);
 
-	writel(ReadValue, &p_register->GPIOxINTENB);
+	nx_gpio_shadow_write(idx, &p_register->GPIOxINTENB, ReadValue);
 
 	nx_gpio_set_detect_enable(idx, irqnum, enable);
 }
@@ -418,10 +497,10 @@ void nx_gpio_set_interrupt_mode(u32 idx, u32 bitnum, int irqmode)
 
 	p_register = gpio_modules[idx].gpio_regs;
 
-	nx_gpio_setbit2(&p_register->GPIOxDETMODE[bitnum / 16],
-			bitnum % 16, (u32)irqmode & 0x03);
-	nx_gpio_setbit(&p_register->GPIOxDETMODEEX, bitnum,
-		       (u32)(irqmode >> 2));
+	nx_gpio_shadow_setbit2(idx, &p_register->GPIOxDETMODE[bitnum / 16],
+			       bitnum % 16, (u32)irqmode & 0x03);
+	nx_gpio_shadow_setbit(idx, &p_register->GPIOxDETMODEEX, bitnum,
+			      (u32)(irqmode >> 2));
 }
 
 int nx_gpio_get_interrupt_mode(u32 idx, u32 bitnum)
@@ -695,6 +774,19 @@ bool nx_alive_get_input_value(u32 bitnum)
 	return (bool)((alive_regs->ALIVEGPIOINPUTVALUE >> bitnum) & 0x01);
 }
 
+void nx_alive_set_output_values(u32 mask, u32 values)
+{
+	if (values & mask)
+		writel(values & mask, &alive_regs->ALIVEGPIOPADOUTSETREG);
+	if (~values & mask)
+		writel(~values & mask, &alive_regs->ALIVEGPIOPADOUTRSTREG);
+}
+
+u32 nx_alive_get_input_values(void)
+{
+	return alive_regs->ALIVEGPIOINPUTVALUE;
+}
+
 u32 nx_alive_get_wakeup_status(void)
 {
 	u32 status;
@@ -725,25 +817,72 @@ const unsigned char s5pxx18_pio_fn_no[][GPIO_NUM_PER_BANK] = {
 #endif
 
 /*----------------------------------------------------------------------------*/
-static spinlock_t lock[ALIVE_INDEX + 1]; /* GPIO A, B, C, D, E, ... alive */
-static unsigned long lock_flags[ALIVE_INDEX + 1];
+/*
+ * Banks by pad group, set up by s5pxx18_base_init(). The bank slock only
+ * guards read-modify-write sequences on the gpio bank registers and
+ * reads that must see several registers at once. Single register reads
+ * and the alive SET/RESET registers are atomic on their own.
+ */
+static struct nexell_pin_bank *io_banks[ALIVE_INDEX + 1];
 
-#define IO_LOCK_INIT(x) spin_lock_init(&lock[x])
-#define IO_LOCK(x) spin_lock_irqsave(&lock[x], lock_flags[x])
-#define IO_UNLOCK(x) spin_unlock_irqrestore(&lock[x], lock_flags[x])
+static inline void nx_bank_lock(struct nexell_pin_bank *bank,
+				unsigned long *flags)
+{
+#ifdef CONFIG_PINCTRL_NEXELL_LOCK_STAT
+	u64 start;
+
+	if (!raw_spin_trylock_irqsave(&bank->slock, *flags)) {
+		start = ktime_get_ns();
+		raw_spin_lock_irqsave(&bank->slock, *flags);
+		bank->lock_wait_ns += ktime_get_ns() - start;
+		bank->lock_contended++;
+	}
+	bank->lock_acquired++;
+#else
+	raw_spin_lock_irqsave(&bank->slock, *flags);
+#endif
+}
+
+static inline void nx_bank_unlock(struct nexell_pin_bank *bank,
+				  unsigned long flags)
+{
+	raw_spin_unlock_irqrestore(&bank->slock, flags);
+}
+
+#define IO_LOCK(x, f)	nx_bank_lock(io_banks[x], &(f))
+#define IO_UNLOCK(x, f)	nx_bank_unlock(io_banks[x], f)
+
+/*
+ * The value and direction accessors are the hot ones: they branch once
+ * on the alive bank and access the register inline. Gpio setters modify
+ * the shadow under the bank lock, alive setters write the SET or RESET
+ * register.
+ */
+static inline bool nx_pad_valid(unsigned int io, const char *func)
+{
+	if (unlikely(io >= PAD_GPIO_ALV + GPIO_NUM_PER_BANK)) {
+		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io,
+		       PAD_GET_GROUP(io), func);
+		return false;
+	}
+
+	pr_debug("%s (%d.%02d)\n", func, PAD_GET_GROUP(io), PAD_GET_BITNO(io));
+	return true;
+}
 
 void nx_soc_gpio_set_io_func(unsigned int io, unsigned int func)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
 	unsigned int bit = PAD_GET_BITNO(io);
+	unsigned long flags;
 
 	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
+		IO_LOCK(grp, flags);
 		nx_gpio_set_pad_function(grp, bit, func);
-		IO_UNLOCK(grp);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
 		break;
@@ -772,9 +911,7 @@ unsigned int nx_soc_gpio_get_io_func(unsigned int io)
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
 		fn = nx_gpio_get_pad_function(grp, bit);
-		IO_UNLOCK(grp);
 		break;
 	case PAD_GPIO_ALV:
 		fn = 0;
@@ -790,75 +927,61 @@ unsigned int nx_soc_gpio_get_io_func(unsigned int io)
 void nx_soc_gpio_set_io_dir(unsigned int io, int out)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
-	unsigned int bit = PAD_GET_BITNO(io);
+	u32 mask = 1U << PAD_GET_BITNO(io);
+	struct nx_gpio_reg_set *regs;
+	unsigned long flags;
+	u32 outenb;
 
-	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
+	if (!nx_pad_valid(io, __func__))
+		return;
 
-	switch (io & ~(32 - 1)) {
-	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
-		nx_gpio_set_output_enable(grp, bit, out ? true : false);
-		IO_UNLOCK(grp);
-		break;
-	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
-		nx_alive_set_output_enable(bit, out ? true : false);
-		IO_UNLOCK(grp);
-		break;
-	default:
-		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
-		       __func__);
-		break;
-	};
+	if (io >= PAD_GPIO_ALV) {
+		writel(mask, out ? &alive_regs->ALIVEGPIOPADOUTENBSETREG :
+				   &alive_regs->ALIVEGPIOPADOUTENBRSTREG);
+		return;
+	}
+
+	regs = gpio_modules[grp].gpio_regs;
+	IO_LOCK(grp, flags);
+	outenb = gpio_modules[grp].gpio_shadow.GPIOxOUTENB;
+	outenb = out ? outenb | mask : outenb & ~mask;
+	nx_gpio_shadow_write(grp, &regs->GPIOxOUTENB, outenb);
+	IO_UNLOCK(grp, flags);
 }
 
 int nx_soc_gpio_get_io_dir(unsigned int io)
 {
-	unsigned int grp = PAD_GET_GROUP(io);
-	unsigned int bit = PAD_GET_BITNO(io);
-	int dir = -1;
+	u32 mask = 1U << PAD_GET_BITNO(io);
 
-	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
+	if (!nx_pad_valid(io, __func__))
+		return -1;
 
-	switch (io & ~(32 - 1)) {
-	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
-		dir = nx_gpio_get_output_enable(grp, bit) ? 1 : 0;
-		IO_UNLOCK(grp);
-		break;
-	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
-		dir = nx_alive_get_output_enable(bit) ? 1 : 0;
-		IO_UNLOCK(grp);
-		break;
-	default:
-		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
-		       __func__);
-		break;
-	};
-	return dir;
+	if (io >= PAD_GPIO_ALV)
+		return !!(readl(&alive_regs->ALIVEGPIOPADOUTENBREADREG) & mask);
+
+	return !!(readl(&gpio_modules[PAD_GET_GROUP(io)].gpio_regs->GPIOxOUTENB) &
+		  mask);
 }
 
 void nx_soc_gpio_set_io_pull(unsigned int io, int val)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
 	unsigned int bit = PAD_GET_BITNO(io);
+	unsigned long flags;
 
 	pr_debug("%s (%d.%02d) sel:%d\n", __func__, grp, bit, val);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
+		IO_LOCK(grp, flags);
 		nx_gpio_set_pull_enable(grp, bit, val);
-		IO_UNLOCK(grp);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		if (val & 1)	/* up */
 			nx_alive_set_pullup_enable(bit, true);
 		else	/* down, off */
 			nx_alive_set_pullup_enable(bit, false);
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -871,20 +994,20 @@ int nx_soc_gpio_get_io_pull(unsigned int io)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
 	unsigned int bit = PAD_GET_BITNO(io);
+	unsigned long flags;
 	int up = -1;
 
 	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
+		/* enable and select must come from the same setting */
+		IO_LOCK(grp, flags);
 		up = nx_gpio_get_pull_enable(grp, bit);
-		IO_UNLOCK(grp);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		up = nx_alive_get_pullup_enable(bit) ? 1 : 0;
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -894,10 +1017,10 @@ int nx_soc_gpio_get_io_pull(unsigned int io)
 
 	return up;
 }
-
 void nx_soc_gpio_set_io_drv(int gpio, int mode)
 {
 	int grp, bit;
+	unsigned long flags;
 
 	if (gpio > (PAD_GPIO_ALV - 1))
 		return;
@@ -906,7 +1029,9 @@ void nx_soc_gpio_set_io_drv(int gpio, int mode)
 	bit = PAD_GET_BITNO(gpio);
 	pr_debug("%s (%d.%02d) mode:%d\n", __func__, grp, bit, mode);
 
+	IO_LOCK(grp, flags);
 	nx_gpio_set_drive_strength(grp, bit, (int)mode);
+	IO_UNLOCK(grp, flags);
 }
 
 int nx_soc_gpio_get_io_drv(int gpio)
@@ -926,73 +1051,98 @@ int nx_soc_gpio_get_io_drv(int gpio)
 void nx_soc_gpio_set_out_value(unsigned int io, int high)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
-	unsigned int bit = PAD_GET_BITNO(io);
+	u32 mask = 1U << PAD_GET_BITNO(io);
+	struct nx_gpio_reg_set *regs;
+	unsigned long flags;
+	u32 out;
 
-	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
+	if (!nx_pad_valid(io, __func__))
+		return;
 
-	switch (io & ~(32 - 1)) {
-	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
-		nx_gpio_set_output_value(grp, bit, high ? true : false);
-		IO_UNLOCK(grp);
-		break;
-	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
-		nx_alive_set_output_value(bit, high ? true : false);
-		IO_UNLOCK(grp);
-		break;
-	default:
-		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
-		       __func__);
-		break;
-	};
+	if (io >= PAD_GPIO_ALV) {
+		writel(mask, high ? &alive_regs->ALIVEGPIOPADOUTSETREG :
+				    &alive_regs->ALIVEGPIOPADOUTRSTREG);
+		return;
+	}
+
+	regs = gpio_modules[grp].gpio_regs;
+	IO_LOCK(grp, flags);
+	out = gpio_modules[grp].gpio_shadow.GPIOxOUT;
+	out = high ? out | mask : out & ~mask;
+	nx_gpio_shadow_write(grp, &regs->GPIOxOUT, out);
+	IO_UNLOCK(grp, flags);
 }
 
-int nx_soc_gpio_get_out_value(unsigned int io)
+/*
+ * io is any pin of the bank, bit n of mask and values is pin n of it.
+ * A gpio bank is updated with one locked read-modify-write of OUT, the
+ * alive bank with at most one SET and one RESET write.
+ */
+void nx_soc_gpio_set_out_values(unsigned int io, u32 mask, u32 values)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
-	unsigned int bit = PAD_GET_BITNO(io);
-	int val = -1;
+	unsigned long flags;
 
-	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
+	pr_debug("%s (%d:0x%08x=0x%08x)\n", __func__, grp, mask, values);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
-		val = nx_gpio_get_output_value(grp, bit) ? 1 : 0;
-		IO_UNLOCK(grp);
+		IO_LOCK(grp, flags);
+		nx_gpio_set_output_values(grp, mask, values);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
-		val = nx_alive_get_output_value(bit) ? 1 : 0;
-		IO_UNLOCK(grp);
+		nx_alive_set_output_values(mask, values);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
 		       __func__);
 		break;
 	};
-	return val;
+}
+
+int nx_soc_gpio_get_out_value(unsigned int io)
+{
+	u32 mask = 1U << PAD_GET_BITNO(io);
+
+	if (!nx_pad_valid(io, __func__))
+		return -1;
+
+	if (io >= PAD_GPIO_ALV)
+		return !!(readl(&alive_regs->ALIVEGPIOPADOUTREADREG) & mask);
+
+	return !!(readl(&gpio_modules[PAD_GET_GROUP(io)].gpio_regs->GPIOxOUT) &
+		  mask);
 }
 
 int nx_soc_gpio_get_in_value(unsigned int io)
+{
+	u32 mask = 1U << PAD_GET_BITNO(io);
+
+	if (!nx_pad_valid(io, __func__))
+		return -1;
+
+	if (io >= PAD_GPIO_ALV)
+		return !!(readl(&alive_regs->ALIVEGPIOINPUTVALUE) & mask);
+
+	return !!(readl(&gpio_modules[PAD_GET_GROUP(io)].gpio_regs->GPIOxPAD) &
+		  mask);
+}
+
+/* pad levels of the whole bank of io, bit n is pin n */
+u32 nx_soc_gpio_get_in_values(unsigned int io)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
-	unsigned int bit = PAD_GET_BITNO(io);
-	int val = -1;
+	u32 val = 0;
 
-	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
+	pr_debug("%s (%d)\n", __func__, grp);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
-		val = nx_gpio_get_input_value(grp, bit) ? 1 : 0;
-		IO_UNLOCK(grp);
+		val = nx_gpio_get_input_values(grp);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
-		val = nx_alive_get_input_value(bit) ? 1 : 0;
-		IO_UNLOCK(grp);
+		val = nx_alive_get_input_values();
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1006,20 +1156,19 @@ void nx_soc_gpio_set_int_enable(unsigned int io, int on)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
 	unsigned int bit = PAD_GET_BITNO(io);
+	unsigned long flags;
 
 	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
+		IO_LOCK(grp, flags);
 		nx_gpio_set_interrupt_enable(grp, bit, on ? true : false);
-		IO_UNLOCK(grp);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		nx_alive_set_detect_enable(bit, on ? true : false);
 		nx_alive_set_interrupt_enable(bit, on ? true : false);
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1038,14 +1187,10 @@ int nx_soc_gpio_get_int_enable(unsigned int io)
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
 		enb = nx_gpio_get_interrupt_enable(grp, bit) ? 1 : 0;
-		IO_UNLOCK(grp);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		enb = nx_alive_get_interrupt_enable(bit) ? 1 : 0;
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1059,25 +1204,24 @@ void nx_soc_gpio_set_int_mode(unsigned int io, unsigned int mode)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
 	unsigned int bit = PAD_GET_BITNO(io);
+	unsigned long flags;
 	int det = 0;
 
 	pr_debug("%s (%d.%02d, %d)\n", __func__, grp, bit, mode);
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
+		IO_LOCK(grp, flags);
 		nx_gpio_set_interrupt_mode(grp, bit, mode);
-		IO_UNLOCK(grp);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		/* all disable */
 		for (det = 0; 6 > det; det++)
 			nx_alive_set_detect_mode(det, bit, false);
 		/* enable */
 		nx_alive_set_detect_mode(mode, bit, true);
 		nx_alive_set_output_enable(bit, false);
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1090,6 +1234,7 @@ int nx_soc_gpio_get_int_mode(unsigned int io)
 {
 	unsigned int grp = PAD_GET_GROUP(io);
 	unsigned int bit = PAD_GET_BITNO(io);
+	unsigned long flags;
 	int mod = -1;
 	int det = 0;
 
@@ -1097,19 +1242,18 @@ int nx_soc_gpio_get_int_mode(unsigned int io)
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
+		/* the mode spans DETMODE and DETMODEEX */
+		IO_LOCK(grp, flags);
 		mod = nx_gpio_get_interrupt_mode(grp, bit);
-		IO_UNLOCK(grp);
+		IO_UNLOCK(grp, flags);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		for (det = 0; 6 > det; det++) {
 			if (nx_alive_get_detect_mode(det, bit)) {
 				mod = det;
 				break;
 			}
 		}
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1129,14 +1273,10 @@ int nx_soc_gpio_get_int_pend(unsigned int io)
 
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
 		pend = nx_gpio_get_interrupt_pending(grp, bit) ? 1 : 0;
-		IO_UNLOCK(grp);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		pend = nx_alive_get_interrupt_pending(bit) ? 1 : 0;
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1153,18 +1293,15 @@ void nx_soc_gpio_clr_int_pend(unsigned int io)
 
 	pr_debug("%s (%d.%02d)\n", __func__, grp, bit);
 
+	/* write 1 to clear, read back to post the write */
 	switch (io & ~(32 - 1)) {
 	CASE_PAD_GPIOS:
-		IO_LOCK(grp);
 		nx_gpio_clear_interrupt_pending(grp, bit);
 		nx_gpio_get_interrupt_pending(grp, bit);
-		IO_UNLOCK(grp);
 		break;
 	case PAD_GPIO_ALV:
-		IO_LOCK(grp);
 		nx_alive_clear_interrupt_pending(bit);
 		nx_alive_get_interrupt_pending(bit);
-		IO_UNLOCK(grp);
 		break;
 	default:
 		pr_err("fail, soc gpio io:%d, group:%d (%s)\n", io, grp,
@@ -1179,26 +1316,17 @@ void nx_soc_alive_set_det_enable(unsigned int io, int on)
 
 	pr_debug("%s (%d)\n", __func__, bit);
 
-	IO_LOCK(ALIVE_INDEX);
-
 	nx_alive_set_output_enable(bit, false);
 	nx_alive_set_detect_enable(bit, on ? true : false);
-
-	IO_UNLOCK(ALIVE_INDEX);
 }
 
 int nx_soc_alive_get_det_enable(unsigned int io)
 {
 	unsigned int bit = PAD_GET_BITNO(io);
-	int mod = 0;
 
 	pr_debug("%s (%d)\n", __func__, bit);
 
-	IO_LOCK(ALIVE_INDEX);
-	mod = nx_alive_get_detect_enable(bit) ? 1 : 0;
-	IO_UNLOCK(ALIVE_INDEX);
-
-	return mod;
+	return nx_alive_get_detect_enable(bit) ? 1 : 0;
 }
 
 void nx_soc_alive_set_det_mode(unsigned int io, unsigned int mode, int on)
@@ -1207,37 +1335,25 @@ void nx_soc_alive_set_det_mode(unsigned int io, unsigned int mode, int on)
 
 	pr_debug("%s (%d)\n", __func__, bit);
 
-	IO_LOCK(ALIVE_INDEX);
 	nx_alive_set_detect_mode(mode, bit, on ? true : false);
-	IO_UNLOCK(ALIVE_INDEX);
 }
 
 int nx_soc_alive_get_det_mode(unsigned int io, unsigned int mode)
 {
 	unsigned int bit = PAD_GET_BITNO(io);
-	int mod = 0;
 
 	pr_debug("%s (%d)\n", __func__, bit);
 
-	IO_LOCK(ALIVE_INDEX);
-	mod = nx_alive_get_detect_mode(mode, bit) ? 1 : 0;
-	IO_UNLOCK(ALIVE_INDEX);
-
-	return mod;
+	return nx_alive_get_detect_mode(mode, bit) ? 1 : 0;
 }
 
 int nx_soc_alive_get_int_pend(unsigned int io)
 {
 	unsigned int bit = PAD_GET_BITNO(io);
-	int pend = -1;
 
 	pr_debug("%s (%d)\n", __func__, bit);
 
-	IO_LOCK(ALIVE_INDEX);
-	pend = nx_alive_get_interrupt_pending(bit);
-	IO_UNLOCK(ALIVE_INDEX);
-
-	return pend;
+	return nx_alive_get_interrupt_pending(bit);
 }
 
 void nx_soc_alive_clr_int_pend(unsigned int io)
@@ -1246,47 +1362,15 @@ void nx_soc_alive_clr_int_pend(unsigned int io)
 
 	pr_debug("%s (%d)\n", __func__, bit);
 
-	IO_LOCK(ALIVE_INDEX);
 	nx_alive_clear_interrupt_pending(bit);
-	IO_UNLOCK(ALIVE_INDEX);
 }
 
+/* the shadow is always current, nothing to read back from the bank */
 static int s5pxx18_gpio_suspend(int idx)
 {
-	struct nx_gpio_reg_set *reg;
-	struct nx_gpio_reg_set *gpio_save;
-
 	if (idx < 0 || idx >= NUMBER_OF_GPIO_MODULE)
 		return -ENXIO;
 
-	reg = gpio_modules[idx].gpio_regs;
-	gpio_save = &gpio_modules[idx].gpio_save;
-
-	gpio_save->GPIOxOUT = readl(&reg->GPIOxOUT);
-	gpio_save->GPIOxOUTENB = readl(&reg->GPIOxOUTENB);
-	gpio_save->GPIOxALTFN[0] = readl(&reg->GPIOxALTFN[0]);
-	gpio_save->GPIOxALTFN[1] = readl(&reg->GPIOxALTFN[1]);
-	gpio_save->GPIOxDETMODE[0] = readl(&reg->GPIOxDETMODE[0]);
-	gpio_save->GPIOxDETMODE[1] = readl(&reg->GPIOxDETMODE[1]);
-	gpio_save->GPIOxDETMODEEX = readl(&reg->GPIOxDETMODEEX);
-	gpio_save->GPIOxINTENB = readl(&reg->GPIOxINTENB);
-
-	gpio_save->GPIOx_SLEW = readl(&reg->GPIOx_SLEW);
-	gpio_save->GPIOx_SLEW_DISABLE_DEFAULT =
-		readl(&reg->GPIOx_SLEW_DISABLE_DEFAULT);
-	gpio_save->GPIOx_DRV1 = readl(&reg->GPIOx_DRV1);
-	gpio_save->GPIOx_DRV1_DISABLE_DEFAULT =
-		readl(&reg->GPIOx_DRV1_DISABLE_DEFAULT);
-	gpio_save->GPIOx_DRV0 = readl(&reg->GPIOx_DRV0);
-	gpio_save->GPIOx_DRV0_DISABLE_DEFAULT =
-		readl(&reg->GPIOx_DRV0_DISABLE_DEFAULT);
-	gpio_save->GPIOx_PULLSEL = readl(&reg->GPIOx_PULLSEL);
-	gpio_save->GPIOx_PULLSEL_DISABLE_DEFAULT =
-		readl(&reg->GPIOx_PULLSEL_DISABLE_DEFAULT);
-	gpio_save->GPIOx_PULLENB = readl(&reg->GPIOx_PULLENB);
-	gpio_save->GPIOx_PULLENB_DISABLE_DEFAULT =
-		readl(&reg->GPIOx_PULLENB_DISABLE_DEFAULT);
-
 	return 0;
 }
 
@@ -1299,7 +1383,7 @@ static int s5pxx18_gpio_resume(int idx)
 		return -ENXIO;
 
 	reg = gpio_modules[idx].gpio_regs;
-	gpio_save = &gpio_modules[idx].gpio_save;
+	gpio_save = &gpio_modules[idx].gpio_shadow;
 
 	writel(gpio_save->GPIOx_SLEW, &reg->GPIOx_SLEW);
 	writel(gpio_save->GPIOx_SLEW_DISABLE_DEFAULT,
@@ -1325,7 +1409,7 @@ static int s5pxx18_gpio_resume(int idx)
 	writel(gpio_save->GPIOxDETMODE[1], &reg->GPIOxDETMODE[1]);
 	writel(gpio_save->GPIOxDETMODEEX, &reg->GPIOxDETMODEEX);
 	writel(gpio_save->GPIOxINTENB, &reg->GPIOxINTENB);
-	writel(gpio_save->GPIOxINTENB, &reg->GPIOxDETENB);/* DETECT ENABLE */
+	writel(gpio_save->GPIOxDETENB, &reg->GPIOxDETENB);/* DETECT ENABLE */
 	writel((u32)0xFFFFFFFF, &reg->GPIOxDET);	/* CLEAR PENDING */
 
 	return 0;
@@ -1443,12 +1527,8 @@ static int s5pxx18_alive_resume(void)
 static int s5pxx18_gpio_device_init(struct list_head *banks, int nr_banks)
 {
 	struct module_init_data *init_data;
-	int n = ALIVE_INDEX + 1;
 	int i;
 
-	for (i = 0; n > i; i++)
-		IO_LOCK_INIT(i);
-
 	gpio_fn_no = s5pxx18_pio_fn_no;
 
 	i = 0;
@@ -1488,55 +1568,50 @@ static void irq_gpio_ack(struct irq_data *irqd)
 	pr_debug("%s: gpio irq=%d, grp=%d, %s.%d\n", __func__, bank->irq, grp,
 		 bank->name, bit);
 
-	IO_LOCK(grp);
 	writel((1 << bit), base + GPIO_INT_STATUS); /* irq pend clear */
 	ARM_DMB();
-	IO_UNLOCK(grp);
 }
 
 static void irq_gpio_mask(struct irq_data *irqd)
 {
 	struct nexell_pin_bank *bank = irq_data_get_irq_chip_data(irqd);
 	int bit = (int)(irqd->hwirq);
-	void __iomem *base = bank->virt_base;
 	unsigned int grp = PAD_GET_GROUP(bank->grange.pin_base + bit);
+	unsigned long flags;
 
 	pr_debug("%s: gpio irq=%d, grp=%d, %s.%d\n", __func__, bank->irq, grp,
 		 bank->name, bit);
 
 	/* mask:irq disable */
-	IO_LOCK(grp);
-	writel(readl(base + GPIO_INT_ENB) & ~(1 << bit), base + GPIO_INT_ENB);
-	writel(readl(base + GPIO_INT_DET) & ~(1 << bit), base + GPIO_INT_DET);
-	IO_UNLOCK(grp);
+	nx_bank_lock(bank, &flags);
+	nx_gpio_set_interrupt_enable(grp, bit, false);
+	nx_bank_unlock(bank, flags);
 }
 
 static void irq_gpio_unmask(struct irq_data *irqd)
 {
 	struct nexell_pin_bank *bank = irq_data_get_irq_chip_data(irqd);
 	int bit = (int)(irqd->hwirq);
-	void __iomem *base = bank->virt_base;
 	unsigned int grp = PAD_GET_GROUP(bank->grange.pin_base + bit);
+	unsigned long flags;
 
 	pr_debug("%s: gpio irq=%d, grp=%d, %s.%d\n", __func__, bank->irq, grp,
 		 bank->name, bit);
 
 	/* unmask:irq enable */
-	IO_LOCK(grp);
-	writel(readl(base + GPIO_INT_ENB) | (1 << bit), base + GPIO_INT_ENB);
-	writel(readl(base + GPIO_INT_DET) | (1 << bit), base + GPIO_INT_DET);
+	nx_bank_lock(bank, &flags);
+	nx_gpio_set_interrupt_enable(grp, bit, true);
 	ARM_DMB();
-	IO_UNLOCK(grp);
+	nx_bank_unlock(bank, flags);
 }
 
 static int irq_gpio_set_type(struct irq_data *irqd, unsigned int type)
 {
 	struct nexell_pin_bank *bank = irq_data_get_irq_chip_data(irqd);
 	int bit = (int)(irqd->hwirq);
-	void __iomem *base = bank->virt_base;
-	u32 val, alt;
-	ulong reg;
 	unsigned int grp = PAD_GET_GROUP(bank->grange.pin_base + bit);
+	unsigned long flags;
+	u32 alt;
 
 	int mode = 0;
 
@@ -1567,31 +1642,18 @@ static int irq_gpio_set_type(struct irq_data *irqd, unsigned int type)
 		return -1;
 	}
 
+	alt = nx_soc_gpio_get_altnum(bank->grange.pin_base + bit);
+
 	/*
-	 * must change mode to gpio to use gpio interrupt
+	 * must change mode to gpio to use gpio interrupt: output disable,
+	 * interrupt mode and gpio function for irq in one lock hold
 	 */
+	nx_bank_lock(bank, &flags);
+	nx_gpio_set_output_enable(grp, bit, false);
+	nx_gpio_set_interrupt_mode(grp, bit, mode);
+	nx_gpio_set_pad_function(grp, bit, alt);
+	nx_bank_unlock(bank, flags);
 
-	/* gpio out : output disable */
-	IO_LOCK(grp);
-	writel(readl(base + GPIO_INT_OUT) & ~(1 << bit), base + GPIO_INT_OUT);
-	IO_UNLOCK(grp);
-
-	/* gpio mode : interrupt mode */
-	reg = (ulong)(base + GPIO_INT_MODE0 + (bit / 16) * 4);
-	val = (readl((void *)reg) & ~(3 << ((bit & 0xf) * 2))) |
-	      ((mode & 0x3) << ((bit & 0xf) * 2));
-	writel(val, (void *)reg);
-
-	reg = (ulong)(base + GPIO_INT_MODE1);
-	val = (readl((void *)reg) & ~(1 << bit)) | (((mode >> 2) & 0x1) << bit);
-	writel(val, (void *)reg);
-
-	/* gpio alt : gpio mode for irq */
-	reg = (ulong)(base + GPIO_INT_ALT + (bit / 16) * 4);
-	val = readl((void *)reg) & ~(3 << ((bit & 0xf) * 2));
-	alt = nx_soc_gpio_get_altnum(bank->grange.pin_base + bit);
-	val |= alt << ((bit & 0xf) * 2);
-	writel(val, (void *)reg);
 	pr_debug("%s: set func to gpio. alt:%d, base:%d, bit:%d\n", __func__,
 		 alt, bank->grange.pin_base, bit);
 
@@ -1602,34 +1664,32 @@ static void irq_gpio_enable(struct irq_data *irqd)
 {
 	struct nexell_pin_bank *bank = irq_data_get_irq_chip_data(irqd);
 	int bit = (int)(irqd->hwirq);
-	void __iomem *base = bank->virt_base;
 	unsigned int grp = PAD_GET_GROUP(bank->grange.pin_base + bit);
+	unsigned long flags;
 
 	pr_debug("%s: gpio irq=%d, grp=%d, %s.%d\n", __func__, bank->irq, grp,
 		 bank->name, bit);
 
 	/* unmask:irq enable */
-	IO_LOCK(grp);
-	writel(readl(base + GPIO_INT_ENB) | (1 << bit), base + GPIO_INT_ENB);
-	writel(readl(base + GPIO_INT_DET) | (1 << bit), base + GPIO_INT_DET);
-	IO_UNLOCK(grp);
+	nx_bank_lock(bank, &flags);
+	nx_gpio_set_interrupt_enable(grp, bit, true);
+	nx_bank_unlock(bank, flags);
 }
 
 static void irq_gpio_disable(struct irq_data *irqd)
 {
 	struct nexell_pin_bank *bank = irq_data_get_irq_chip_data(irqd);
 	int bit = (int)(irqd->hwirq);
-	void __iomem *base = bank->virt_base;
 	unsigned int grp = PAD_GET_GROUP(bank->grange.pin_base + bit);
+	unsigned long flags;
 
 	pr_debug("%s: gpio irq=%d, grp=%d, %s.%d\n", __func__, bank->irq, grp,
 		 bank->name, bit);
 
 	/* mask:irq disable */
-	IO_LOCK(grp);
-	writel(readl(base + GPIO_INT_ENB) & ~(1 << bit), base + GPIO_INT_ENB);
-	writel(readl(base + GPIO_INT_DET) & ~(1 << bit), base + GPIO_INT_DET);
-	IO_UNLOCK(grp);
+	nx_bank_lock(bank, &flags);
+	nx_gpio_set_interrupt_enable(grp, bit, false);
+	nx_bank_unlock(bank, flags);
 }
 
 /*
@@ -1666,34 +1726,63 @@ static const struct irq_domain_ops s5pxx18_gpio_irqd_ops = {
 	.map = s5pxx18_gpio_irq_map, .xlate = irq_domain_xlate_twocell,
 };
 
+/* status re-reads per parent entry before a busy bank gives the cpu back */
+#define NX_IRQ_DEMUX_ROUNDS	4
+
+/*
+ * Handle every enabled pending pin of a bank in one parent entry, then
+ * re-read the status until it is quiet. A pin with no mapping has its
+ * status cleared so it cannot keep the parent asserted, and counts as
+ * handled. Returns the number of pins serviced, 0 if no enabled pin was
+ * pending.
+ */
+static unsigned int s5pxx18_irq_demux(struct nexell_pin_bank *bank,
+				      void __iomem *status, void __iomem *enb)
+{
+	unsigned int virq, handled = 0;
+	int round, bit;
+	u32 stat;
+
+	for (round = 0; round < NX_IRQ_DEMUX_ROUNDS; round++) {
+		stat = readl(status);
+		if (stat)
+			stat &= readl(enb);
+		if (!stat)
+			break;
+
+		for (; stat; stat &= stat - 1) {
+			bit = __ffs(stat);
+			virq = irq_linear_revmap(bank->irq_domain, bit);
+			if (!virq) {
+				bank->irq_spurious++;
+				writel(1 << bit, status);
+				handled++;
+				continue;
+			}
+			pr_debug("%s irq [%d] (hw %u), round %d\n",
+				 bank->name, bit, virq, round);
+			generic_handle_irq(virq);
+			handled++;
+		}
+	}
+
+	return handled;
+}
+
 static irqreturn_t s5pxx18_gpio_irq_handler(int irq, void *data)
 {
 	struct nexell_pin_bank *bank = data;
 	void __iomem *base = bank->virt_base;
-	u32 stat, mask;
-	unsigned int virq;
-	int bit;
-
-	mask = readl(base + GPIO_INT_ENB);
-	stat = readl(base + GPIO_INT_STATUS) & mask;
-	bit = ffs(stat) - 1;
-
-	if (-1 == bit) {
-		pr_err("Unknown gpio irq=%d, status=0x%08x, mask=0x%08x\r\n",
-		       irq, stat, mask);
-		writel(-1, (base + GPIO_INT_STATUS)); /* clear gpio status all*/
-		return IRQ_NONE;
-	}
-
-	virq = irq_linear_revmap(bank->irq_domain, bit);
-	if (!virq)
-		return IRQ_NONE;
 
-	pr_debug("Gpio irq=%d [%d] (hw %u), stat=0x%08x, mask=0x%08x\n", irq,
-		 bit, virq, stat, mask);
-	generic_handle_irq(virq);
+	if (s5pxx18_irq_demux(bank, base + GPIO_INT_STATUS,
+			      base + GPIO_INT_ENB))
+		return IRQ_HANDLED;
 
-	return IRQ_HANDLED;
+	/* disabled pins pending stay latched for their unmask */
+	bank->irq_unknown++;
+	pr_err("Unknown gpio irq=%d, status=0x%08x, mask=0x%08x\r\n",
+	       irq, readl(base + GPIO_INT_STATUS), readl(base + GPIO_INT_ENB));
+	return IRQ_NONE;
 }
 
 /*
@@ -1898,30 +1987,16 @@ static irqreturn_t s5pxx18_alive_irq_handler(int irq, void *data)
 {
 	struct nexell_pin_bank *bank = data;
 	void __iomem *base = bank->virt_base;
-	u32 stat, mask;
-	unsigned int virq;
-	int bit;
-
-	mask = readl(base + ALIVE_INT_SET_READ);
-	stat = readl(base + ALIVE_INT_STATUS) & mask;
-	bit = ffs(stat) - 1;
-
-	if (-1 == bit) {
-		pr_err("Unknown alive irq=%d, status=0x%08x, mask=0x%08x\r\n",
-		       irq, stat, mask);
-		writel(-1, (base + ALIVE_INT_STATUS)); /* clear alive status */
-		return IRQ_NONE;
-	}
-
-	virq = irq_linear_revmap(bank->irq_domain, bit);
-	pr_debug("alive irq=%d [%d] (hw %u), stat=0x%08x, mask=0x%08x\n", irq,
-		 bit, virq, stat, mask);
-	if (!virq)
-		return IRQ_NONE;
 
-	generic_handle_irq(virq);
+	if (s5pxx18_irq_demux(bank, base + ALIVE_INT_STATUS,
+			      base + ALIVE_INT_SET_READ))
+		return IRQ_HANDLED;
 
-	return IRQ_HANDLED;
+	bank->irq_unknown++;
+	pr_err("Unknown alive irq=%d, status=0x%08x, mask=0x%08x\r\n",
+	       irq, readl(base + ALIVE_INT_STATUS),
+	       readl(base + ALIVE_INT_SET_READ));
+	return IRQ_NONE;
 }
 
 static int s5pxx18_alive_irq_map(struct irq_domain *h, unsigned int virq,
@@ -2077,11 +2152,68 @@ static void s5pxx18_resume(struct nexell_pinctrl_drv_data *drvdata)
 	print_wake_event();
 }
 
+static int s5pxx18_irqstat_show(struct seq_file *m, void *unused)
+{
+	struct nexell_pinctrl_drv_data *drvdata = m->private;
+	struct nexell_pin_bank *bank = drvdata->ctrl->pin_banks;
+	int i;
+
+	seq_printf(m, "%-8s %12s %12s\n", "bank", "unknown", "spurious");
+	for (i = 0; i < drvdata->ctrl->nr_banks; i++, bank++)
+		seq_printf(m, "%-8s %12u %12u\n", bank->name,
+			   READ_ONCE(bank->irq_unknown),
+			   READ_ONCE(bank->irq_spurious));
+	return 0;
+}
+
+static int s5pxx18_irqstat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s5pxx18_irqstat_show, inode->i_private);
+}
+
+static const struct file_operations s5pxx18_irqstat_fops = {
+	.owner = THIS_MODULE,
+	.open = s5pxx18_irqstat_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+#ifdef CONFIG_PINCTRL_NEXELL_LOCK_STAT
+static int s5pxx18_lockstat_show(struct seq_file *m, void *unused)
+{
+	struct nexell_pinctrl_drv_data *drvdata = m->private;
+	struct nexell_pin_bank *bank = drvdata->ctrl->pin_banks;
+	int i;
+
+	seq_printf(m, "%-8s %12s %12s %16s\n", "bank", "acquired",
+		   "contended", "wait_ns");
+	for (i = 0; i < drvdata->ctrl->nr_banks; i++, bank++)
+		seq_printf(m, "%-8s %12u %12u %16llu\n", bank->name,
+			   bank->lock_acquired, bank->lock_contended,
+			   bank->lock_wait_ns);
+	return 0;
+}
+
+static int s5pxx18_lockstat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s5pxx18_lockstat_show, inode->i_private);
+}
+
+static const struct file_operations s5pxx18_lockstat_fops = {
+	.owner = THIS_MODULE,
+	.open = s5pxx18_lockstat_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+#endif
+
 static int s5pxx18_base_init(struct nexell_pinctrl_drv_data *drvdata)
 {
 	struct nexell_pin_ctrl *ctrl = drvdata->ctrl;
 	int nr_banks = ctrl->nr_banks;
-	int ret;
+	int ret = 0;
 	int i;
 	struct module_init_data *init_data, *n;
 	LIST_HEAD(banks);
@@ -2099,11 +2231,22 @@ static int s5pxx18_base_init(struct nexell_pinctrl_drv_data *drvdata)
 		init_data->bank_base = bank->virt_base;
 		init_data->bank_type = bank->eint_type;
 
+		/* gpio banks come first in group order, then alive */
+		io_banks[bank->eint_type == EINT_TYPE_WKUP ? ALIVE_INDEX : i] =
+			bank;
+
 		list_add_tail(&init_data->node, &banks);
 	}
 
 	s5pxx18_gpio_device_init(&banks, nr_banks);
 
+	debugfs_create_file("nexell-pinctrl-irqstat", 0400, NULL, drvdata,
+			    &s5pxx18_irqstat_fops);
+#ifdef CONFIG_PINCTRL_NEXELL_LOCK_STAT
+	debugfs_create_file("nexell-pinctrl-lockstat", 0400, NULL, drvdata,
+			    &s5pxx18_lockstat_fops);
+#endif
+
 done:
 	/* free */
 	list_for_each_entry_safe(init_data, n, &banks, node) {
@@ -2111,7 +2254,7 @@ done:
 		kfree(init_data);
 	}
 
-	return 0;
+	return ret;
 }
 
 #ifdef CONFIG_PINCTRL_S5PXX18
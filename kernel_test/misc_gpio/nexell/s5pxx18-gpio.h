@@ -108,13 +108,13 @@
 #define PAD_STRENGTH_2 ((PIN_STRENGTH_2 & PAD_ST_MASK) << PAD_ST_POS)
 #define PAD_STRENGTH_3 ((PIN_STRENGTH_3 & PAD_ST_MASK) << PAD_ST_POS)
 
-#define PAD_GET_GROUP(pin) ((pin >> 0x5) & 0x07) /* Divide 32 */
-#define PAD_GET_BITNO(pin) (pin & 0x1F)
-#define PAD_GET_FUNC(pin) ((pin >> PAD_FN_POS) & PAD_FN_MASK)
-#define PAD_GET_MODE(pin) ((pin >> PAD_MD_POS) & PAD_MD_MASK)
-#define PAD_GET_LEVEL(pin) ((pin >> PAD_LV_POS) & PAD_LV_MASK)
-#define PAD_GET_PULLUP(pin) ((pin >> PAD_PU_POS) & PAD_PU_MASK)
-#define PAD_GET_STRENGTH(pin) ((pin >> PAD_ST_POS) & PAD_ST_MASK)
+#define PAD_GET_GROUP(pin) (((pin) >> 0x5) & 0x07) /* Divide 32 */
+#define PAD_GET_BITNO(pin) ((pin) & 0x1F)
+#define PAD_GET_FUNC(pin) (((pin) >> PAD_FN_POS) & PAD_FN_MASK)
+#define PAD_GET_MODE(pin) (((pin) >> PAD_MD_POS) & PAD_MD_MASK)
+#define PAD_GET_LEVEL(pin) (((pin) >> PAD_LV_POS) & PAD_LV_MASK)
+#define PAD_GET_PULLUP(pin) (((pin) >> PAD_PU_POS) & PAD_PU_MASK)
+#define PAD_GET_STRENGTH(pin) (((pin) >> PAD_ST_POS) & PAD_ST_MASK)
 
 
 /*
@@ -667,6 +667,8 @@ extern int nx_soc_gpio_get_io_drv(int gpio);
 extern void nx_soc_gpio_set_out_value(unsigned int io, int high);
 extern int nx_soc_gpio_get_out_value(unsigned int io);
 extern int nx_soc_gpio_get_in_value(unsigned int io);
+extern void nx_soc_gpio_set_out_values(unsigned int io, u32 mask, u32 values);
+extern u32 nx_soc_gpio_get_in_values(unsigned int io);
 extern void nx_soc_gpio_set_int_enable(unsigned int io, int on);
 extern int nx_soc_gpio_get_int_enable(unsigned int io);
 extern void nx_soc_gpio_set_int_mode(unsigned int io, unsigned int mode);
@@ -0,0 +1,283 @@
+/*
+ * In-memory model of the s5pxx18 GPIO banks and the alive block,
+ * see nx-gpio-sim.h for the register semantics.
+ */
+
+#include <time.h>
+
+#include "../s5pxx18-gpio.h"
+#include "../pinctrl-s5pxx18.h"
+
+struct nx_sim_stats nx_sim_stats;
+
+static struct nx_gpio_reg_set sim_gpio[NR_GPIO_MODULE];
+static struct nx_alive_reg_set sim_alive;
+static u32 sim_gpio_in[NR_GPIO_MODULE];
+static u32 sim_alive_in;
+
+static spinlock_t sim_lock;
+static unsigned int sim_read_ns, sim_write_ns;
+
+#define ALIVE_PIN_MASK	((1U << NR_ALIVE) - 1)
+#define ALIVE_REGS	(sizeof(sim_alive) / sizeof(u32))
+
+enum {
+	ALIVE_PLAIN,
+	ALIVE_RST,		/* clears bits of the READ register */
+	ALIVE_SET,		/* sets bits of the READ register */
+	ALIVE_READ,		/* read-only copy of the state */
+	ALIVE_PEND,		/* write-1-to-clear */
+	ALIVE_INPUT,		/* read-only pad level */
+};
+
+/* role of every alive register, and the READ register of RST/SET */
+static u8 alive_role[ALIVE_REGS];
+static u8 alive_state[ALIVE_REGS];
+
+/* RST offset of each RST/SET/READ triple */
+static const u16 alive_triples[] = {
+	0x04, 0x10, 0x1C, 0x28, 0x34, 0x40, 0x4C, 0x58, 0x68, 0x74, 0x80,
+	0x8C, 0x98, 0xAC, 0xB8, 0xC4, 0xD0, 0xDC, 0xE8, 0xF4, 0x100, 0x10C,
+};
+
+#define REG_IDX(r)	(offsetof(struct nx_alive_reg_set, r) / sizeof(u32))
+
+static void sim_delay(unsigned int ns)
+{
+	struct timespec ts;
+	u64 end;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	end = ts.tv_sec * 1000000000ULL + ts.tv_nsec + ns;
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+	} while (ts.tv_sec * 1000000000ULL + ts.tv_nsec < end);
+}
+
+void nx_sim_reset(void)
+{
+	unsigned int i, r;
+
+	memset(sim_gpio, 0, sizeof(sim_gpio));
+	memset(&sim_alive, 0, sizeof(sim_alive));
+	memset(sim_gpio_in, 0, sizeof(sim_gpio_in));
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	sim_alive_in = 0;
+	spin_lock_init(&sim_lock);
+
+	memset(alive_role, ALIVE_PLAIN, sizeof(alive_role));
+	for (i = 0; i < ARRAY_SIZE(alive_triples); i++) {
+		r = alive_triples[i] / sizeof(u32);
+		alive_role[r] = ALIVE_RST;
+		alive_role[r + 1] = ALIVE_SET;
+		alive_role[r + 2] = ALIVE_READ;
+		alive_state[r] = r + 2;
+		alive_state[r + 1] = r + 2;
+	}
+	alive_role[REG_IDX(ALIVEGPIODETECTPENDREG)] = ALIVE_PEND;
+	alive_role[REG_IDX(ALIVEGPIOINPUTVALUE)] = ALIVE_INPUT;
+}
+
+void nx_sim_set_latency(unsigned int read_ns, unsigned int write_ns)
+{
+	sim_read_ns = read_ns;
+	sim_write_ns = write_ns;
+}
+
+void *nx_sim_gpio_base(int idx)
+{
+	return &sim_gpio[idx];
+}
+
+void *nx_sim_alive_base(void)
+{
+	return &sim_alive;
+}
+
+/* latch DET from the pad transition old -> PAD, caller holds sim_lock */
+static void sim_gpio_update(int idx, u32 old)
+{
+	struct nx_gpio_reg_set *r = &sim_gpio[idx];
+	u32 pad = (r->GPIOxOUT & r->GPIOxOUTENB) |
+		  (sim_gpio_in[idx] & ~r->GPIOxOUTENB);
+	u32 rise = ~old & pad, fall = old & ~pad;
+	u32 enb = r->GPIOxDETENB, det = 0, b;
+	int bit, mode;
+
+	for (; enb; enb &= enb - 1) {
+		bit = __builtin_ctz(enb);
+		b = 1U << bit;
+		mode = ((r->GPIOxDETMODE[bit / 16] >> ((bit % 16) * 2)) & 3) |
+		       (((r->GPIOxDETMODEEX >> bit) & 1) << 2);
+
+		switch (mode) {
+		case NX_GPIO_INTMODE_LOWLEVEL:
+			det |= ~pad & b;
+			break;
+		case NX_GPIO_INTMODE_HIGHLEVEL:
+			det |= pad & b;
+			break;
+		case NX_GPIO_INTMODE_FALLINGEDGE:
+			det |= fall & b;
+			break;
+		case NX_GPIO_INTMODE_RISINGEDGE:
+			det |= rise & b;
+			break;
+		default:
+			det |= (rise | fall) & b;
+			break;
+		}
+	}
+
+	r->GPIOxPAD = pad;
+	r->GPIOxDET |= det;
+}
+
+static void sim_alive_update(u32 old)
+{
+	struct nx_alive_reg_set *r = &sim_alive;
+	u32 outenb = r->ALIVEGPIOPADOUTENBREADREG;
+	u32 pad = ((r->ALIVEGPIOPADOUTREADREG & outenb) |
+		   (sim_alive_in & ~outenb)) & ALIVE_PIN_MASK;
+	u32 rise = ~old & pad, fall = old & ~pad, det;
+
+	det = (rise & r->ALIVEGPIORISEDETECTMODEREADREG) |
+	      (fall & r->ALIVEGPIOFALLDETECTMODEREADREG) |
+	      (pad & (r->ALIVEGPIOHIGHDETECTMODEREADREG |
+		      r->ALIVEGPIOHIGHASYNCDETECTMODEREADREG)) |
+	      (~pad & (r->ALIVEGPIOLOWDETECTMODEREADREG |
+		       r->ALIVEGPIOLOWASYNCDETECTMODEREADREG));
+
+	r->ALIVEGPIOINPUTVALUE = pad;
+	r->ALIVEGPIODETECTPENDREG |=
+		det & r->ALIVEGPIODETECTENBREADREG & ALIVE_PIN_MASK;
+}
+
+void nx_sim_drive(int idx, uint32_t mask, uint32_t levels)
+{
+	u32 old;
+
+	spin_lock(&sim_lock);
+	if (idx >= NR_GPIO_MODULE) {
+		old = sim_alive.ALIVEGPIOINPUTVALUE;
+		sim_alive_in = (sim_alive_in & ~mask) | (levels & mask);
+		sim_alive_update(old);
+	} else {
+		old = sim_gpio[idx].GPIOxPAD;
+		sim_gpio_in[idx] = (sim_gpio_in[idx] & ~mask) | (levels & mask);
+		sim_gpio_update(idx, old);
+	}
+	spin_unlock(&sim_lock);
+}
+
+uint32_t nx_sim_irq_lines(void)
+{
+	u32 lines = 0;
+	int i;
+
+	for (i = 0; i < NR_GPIO_MODULE; i++)
+		if (READ_ONCE(sim_gpio[i].GPIOxDET) &
+		    READ_ONCE(sim_gpio[i].GPIOxINTENB))
+			lines |= 1U << i;
+
+	if (READ_ONCE(sim_alive.ALIVEGPIODETECTPENDREG) &
+	    READ_ONCE(sim_alive.ALIVEGPIOINTENBREADREG))
+		lines |= 1U << ALIVE_INDEX;
+
+	return lines;
+}
+
+/* bank and register offset of addr, -1 if it is not a model register */
+static int sim_decode(const volatile void *addr, unsigned int *off)
+{
+	const char *p = (const char *)addr;
+	const char *g = (const char *)sim_gpio;
+
+	if (p >= g && p < g + sizeof(sim_gpio)) {
+		*off = (p - g) % sizeof(struct nx_gpio_reg_set);
+		return (p - g) / sizeof(struct nx_gpio_reg_set);
+	}
+	if (p >= (const char *)&sim_alive &&
+	    p < (const char *)&sim_alive + sizeof(sim_alive)) {
+		*off = p - (const char *)&sim_alive;
+		return ALIVE_INDEX;
+	}
+	return -1;
+}
+
+uint32_t nx_sim_readl(const volatile void *addr)
+{
+	unsigned int off;
+	u32 val;
+	int idx;
+
+	__atomic_fetch_add(&nx_sim_stats.reads, 1, __ATOMIC_RELAXED);
+	if (sim_read_ns)
+		sim_delay(sim_read_ns);
+
+	idx = sim_decode(addr, &off);
+	if (idx < 0)
+		return *(const volatile u32 *)addr;
+
+	spin_lock(&sim_lock);
+	if (idx == ALIVE_INDEX &&
+	    (alive_role[off / 4] == ALIVE_RST || alive_role[off / 4] == ALIVE_SET))
+		val = ((u32 *)&sim_alive)[alive_state[off / 4]];
+	else
+		val = *(const volatile u32 *)addr;
+	spin_unlock(&sim_lock);
+
+	return val;
+}
+
+void nx_sim_writel(uint32_t val, volatile void *addr)
+{
+	struct nx_gpio_reg_set *r;
+	u32 *regs = (u32 *)&sim_alive, old;
+	unsigned int off;
+	int idx;
+
+	__atomic_fetch_add(&nx_sim_stats.writes, 1, __ATOMIC_RELAXED);
+	if (sim_write_ns)
+		sim_delay(sim_write_ns);
+
+	idx = sim_decode(addr, &off);
+	if (idx < 0) {
+		*(volatile u32 *)addr = val;
+		return;
+	}
+
+	spin_lock(&sim_lock);
+	if (idx == ALIVE_INDEX) {
+		old = sim_alive.ALIVEGPIOINPUTVALUE;
+
+		switch (alive_role[off / 4]) {
+		case ALIVE_RST:
+			regs[alive_state[off / 4]] &= ~val;
+			break;
+		case ALIVE_SET:
+			regs[alive_state[off / 4]] |= val;
+			break;
+		case ALIVE_PEND:
+			regs[off / 4] &= ~val;
+			break;
+		case ALIVE_READ:
+		case ALIVE_INPUT:
+			break;
+		default:
+			regs[off / 4] = val;
+			break;
+		}
+		sim_alive_update(old);
+	} else {
+		r = &sim_gpio[idx];
+		old = r->GPIOxPAD;
+
+		if (off == offsetof(struct nx_gpio_reg_set, GPIOxDET))
+			r->GPIOxDET &= ~val;
+		else if (off != offsetof(struct nx_gpio_reg_set, GPIOxPAD))
+			*(volatile u32 *)addr = val;
+		sim_gpio_update(idx, old);
+	}
+	spin_unlock(&sim_lock);
+}
@@ -0,0 +1,51 @@
+/*
+ * In-memory model of the s5pxx18 GPIO banks and the alive block.
+ *
+ * GPIO banks: OUT/OUTENB/DETMODE/DETMODEEX/INTENB/DETENB/ALTFN and the
+ * pad configuration registers are plain storage. PAD is read-only and
+ * follows OUT where OUTENB is set and the externally driven level
+ * elsewhere. DET is write-1-to-clear and latches the events selected by
+ * DETMODE/DETMODEEX for pins with DETENB set; the bank asserts its
+ * parent irq while DET & INTENB is non zero.
+ *
+ * Alive block: every RST/SET/READ triple keeps its value at the READ
+ * offset, writes to RST clear and writes to SET set the written bits,
+ * reads of RST and SET return the READ value. DETECTPEND is
+ * write-1-to-clear, ALIVEGPIOINPUTVALUE follows the pad. Level detect
+ * modes re-assert the pending bit as long as the level holds.
+ *
+ * The model memory doubles as the register file, so code that
+ * dereferences the register structures directly sees the same state.
+ */
+
+#ifndef __NX_GPIO_SIM_H
+#define __NX_GPIO_SIM_H
+
+struct nx_sim_stats {
+	unsigned long reads;
+	unsigned long writes;
+};
+
+/* access counters since the last nx_sim_reset() */
+extern struct nx_sim_stats nx_sim_stats;
+
+/* clear all registers, inputs and counters */
+void nx_sim_reset(void);
+
+/* busy-wait per access, to emulate slow device-mapped reads and writes */
+void nx_sim_set_latency(unsigned int read_ns, unsigned int write_ns);
+
+/* register bases, idx NR_GPIO_MODULE .. is the alive block */
+void *nx_sim_gpio_base(int idx);
+void *nx_sim_alive_base(void);
+
+/* drive the external level of the masked pins of a bank or the alive block */
+void nx_sim_drive(int idx, uint32_t mask, uint32_t levels);
+
+/* bit idx set while bank idx (ALIVE_INDEX for alive) asserts its irq */
+uint32_t nx_sim_irq_lines(void);
+
+uint32_t nx_sim_readl(const volatile void *addr);
+void nx_sim_writel(uint32_t val, volatile void *addr);
+
+#endif /* __NX_GPIO_SIM_H */
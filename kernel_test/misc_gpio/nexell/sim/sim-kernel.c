@@ -0,0 +1,156 @@
+/*
+ * Minimal irq core for the host build: a flat descriptor table, linear
+ * domains and the level/edge flow handlers the nexell irq chips use.
+ */
+
+#include <assert.h>
+
+static struct irq_desc sim_irq_desc[SIM_NR_IRQS];
+static unsigned int sim_next_virq = 64;	/* below are parent irqs */
+
+struct irq_desc *irq_to_desc(unsigned int irq)
+{
+	assert(irq < SIM_NR_IRQS);
+	return &sim_irq_desc[irq];
+}
+
+struct irq_data *irq_get_irq_data(unsigned int irq)
+{
+	return &irq_to_desc(irq)->irq_data;
+}
+
+int irq_set_chip_data(unsigned int irq, void *data)
+{
+	irq_to_desc(irq)->irq_data.chip_data = data;
+	return 0;
+}
+
+void irq_set_chip_and_handler(unsigned int irq, struct irq_chip *chip,
+			      irq_flow_handler_t handle)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+
+	desc->irq_data.irq = irq;
+	desc->irq_data.chip = chip;
+	desc->handle_irq = handle;
+}
+
+static void sim_handle_action(struct irq_desc *desc)
+{
+	if (desc->action)
+		desc->action(desc->irq_data.irq, desc->dev_id);
+}
+
+void handle_level_irq(struct irq_desc *desc)
+{
+	struct irq_chip *chip = desc->irq_data.chip;
+
+	desc->count++;
+	if (chip->irq_mask)
+		chip->irq_mask(&desc->irq_data);
+	if (chip->irq_ack)
+		chip->irq_ack(&desc->irq_data);
+	sim_handle_action(desc);
+	if (chip->irq_unmask)
+		chip->irq_unmask(&desc->irq_data);
+}
+
+void handle_edge_irq(struct irq_desc *desc)
+{
+	struct irq_chip *chip = desc->irq_data.chip;
+
+	desc->count++;
+	if (chip->irq_ack)
+		chip->irq_ack(&desc->irq_data);
+	sim_handle_action(desc);
+}
+
+int generic_handle_irq(unsigned int irq)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+
+	if (!desc->handle_irq)
+		return -EINVAL;
+	desc->handle_irq(desc);
+	return 0;
+}
+
+struct irq_domain *irq_domain_add_linear(struct device_node *of_node,
+					 unsigned int size,
+					 const struct irq_domain_ops *ops,
+					 void *host_data)
+{
+	struct irq_domain *domain;
+	unsigned int hw;
+
+	if (sim_next_virq + size > SIM_NR_IRQS)
+		return NULL;
+
+	domain = calloc(1, sizeof(*domain));
+	if (!domain)
+		return NULL;
+
+	domain->ops = ops;
+	domain->host_data = host_data;
+	domain->revmap_size = size;
+	domain->virq_base = sim_next_virq;
+	sim_next_virq += size;
+
+	/* the kernel maps on demand, mapping every hwirq up front is enough */
+	for (hw = 0; hw < size; hw++) {
+		irq_to_desc(domain->virq_base + hw)->irq_data.hwirq = hw;
+		ops->map(domain, domain->virq_base + hw, hw);
+	}
+
+	return domain;
+}
+
+void irq_domain_remove(struct irq_domain *domain)
+{
+	free(domain);
+}
+
+int irq_domain_xlate_twocell(struct irq_domain *d, struct device_node *node,
+			     const u32 *intspec, unsigned int intsize,
+			     irq_hw_number_t *out_hwirq, unsigned int *out_type)
+{
+	if (intsize < 2)
+		return -EINVAL;
+	*out_hwirq = intspec[0];
+	*out_type = intspec[1] & IRQ_TYPE_SENSE_MASK;
+	return 0;
+}
+
+int request_irq(unsigned int irq, irq_handler_t handler, unsigned long flags,
+		const char *name, void *dev_id)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+
+	if (desc->action)
+		return -EBUSY;
+
+	desc->irq_data.irq = irq;
+	desc->action = handler;
+	desc->dev_id = dev_id;
+	return 0;
+}
+
+int devm_request_irq(struct device *dev, unsigned int irq,
+		     irq_handler_t handler, unsigned long flags,
+		     const char *name, void *dev_id)
+{
+	return request_irq(irq, handler, flags, name, dev_id);
+}
+
+void devm_free_irq(struct device *dev, unsigned int irq, void *dev_id)
+{
+	irq_to_desc(irq)->action = NULL;
+}
+
+irqreturn_t sim_raise_irq(unsigned int irq)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+
+	desc->count++;
+	return desc->action ? desc->action(irq, desc->dev_id) : IRQ_NONE;
+}
@@ -0,0 +1,407 @@
+/*
+ * Host build of the s5pxx18 pinctrl/GPIO code.
+ *
+ * This header is force-included in front of the driver sources when they
+ * are built for the simulator (see sim/Makefile). The kernel headers the
+ * sources include resolve to empty files, everything they use comes from
+ * here. Register accessors are routed to the in-memory model in
+ * nx-gpio-sim.c, the irq core is reduced to what the chained bank
+ * handlers need to run.
+ */
+
+#ifndef __SIM_KERNEL_H
+#define __SIM_KERNEL_H
+
+#define CONFIG_NX_GPIO_SIM	1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;	/* as in the kernel, for %llu */
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef unsigned long ulong;
+
+typedef u8 __u8;
+typedef u16 __u16;
+typedef u32 __u32;
+typedef u64 __u64;
+
+/* ioctl numbering for the uapi headers */
+#define _IOC(dir, type, nr, size) \
+	(((unsigned)(dir) << 30) | ((unsigned)(size) << 16) | \
+	 ((unsigned)(type) << 8) | (unsigned)(nr))
+#define _IO(type, nr)		_IOC(0, type, nr, 0)
+#define _IOW(type, nr, t)	_IOC(1, type, nr, sizeof(t))
+#define _IOR(type, nr, t)	_IOC(2, type, nr, sizeof(t))
+#define _IOWR(type, nr, t)	_IOC(3, type, nr, sizeof(t))
+
+#define __iomem
+#define __user
+#define __percpu
+#define __init
+#define __exit
+#define __maybe_unused	__attribute__((unused))
+#define EXPORT_SYMBOL(x)
+#define EXPORT_SYMBOL_GPL(x)
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define module_init(x)
+#define module_exit(x)
+
+#define likely(x)	__builtin_expect(!!(x), 1)
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+#define BIT(n)		(1UL << (n))
+#define container_of(p, t, m)	((t *)((char *)(p) - offsetof(t, m)))
+#define min(a, b)	((a) < (b) ? (a) : (b))
+#define max(a, b)	((a) > (b) ? (a) : (b))
+
+#define ffs(x)		__builtin_ffs(x)
+#define fls(x)		((x) ? 32 - __builtin_clz(x) : 0)
+#define __ffs(x)	((unsigned long)__builtin_ctzl(x))
+#define hweight32(x)	__builtin_popcount(x)
+
+#define READ_ONCE(x)		(*(volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)	(*(volatile __typeof__(x) *)&(x) = (v))
+
+/* memory */
+#define GFP_KERNEL	0
+#define GFP_ATOMIC	0
+#define kmalloc(s, f)	malloc(s)
+#define kzalloc(s, f)	calloc(1, s)
+#define kcalloc(n, s, f) calloc(n, s)
+#define kfree(p)	free(p)
+
+/*
+ * logging, pr_debug is compiled out like in a non-DEBUG kernel build:
+ * no_printk() still checks the format and uses the arguments
+ */
+#define no_printk(...)	do { if (0) printf(__VA_ARGS__); } while (0)
+#define KERN_ERR	""
+#define KERN_INFO	""
+#define printk(...)	printf(__VA_ARGS__)
+#define pr_err(...)	fprintf(stderr, __VA_ARGS__)
+#define pr_warn(...)	fprintf(stderr, __VA_ARGS__)
+#define pr_notice(...)	fprintf(stderr, __VA_ARGS__)
+#define pr_info(...)	no_printk(__VA_ARGS__)
+#define pr_debug(...)	no_printk(__VA_ARGS__)
+#define dev_err(d, ...)	fprintf(stderr, __VA_ARGS__)
+#define dev_warn(d, ...) fprintf(stderr, __VA_ARGS__)
+#define dev_info(d, ...) no_printk(__VA_ARGS__)
+#define dev_dbg(d, ...)	((void)0)
+
+struct device {
+	const char *name;
+};
+
+struct device_node {
+	const char *name;
+};
+
+static inline const char *dev_name(const struct device *dev)
+{
+	return dev && dev->name ? dev->name : "sim";
+}
+
+/* lists */
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name)	{ &(name), &(name) }
+#define LIST_HEAD(name)		struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline void list_add_tail(struct list_head *entry,
+				 struct list_head *head)
+{
+	entry->prev = head->prev;
+	entry->next = head;
+	head->prev->next = entry;
+	head->prev = entry;
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+}
+
+#define list_entry(p, t, m)	container_of(p, t, m)
+#define list_for_each_entry(pos, head, member)				\
+	for (pos = list_entry((head)->next, __typeof__(*pos), member);	\
+	     &pos->member != (head);					\
+	     pos = list_entry(pos->member.next, __typeof__(*pos), member))
+#define list_for_each_entry_safe(pos, n, head, member)			\
+	for (pos = list_entry((head)->next, __typeof__(*pos), member),	\
+	     n = list_entry(pos->member.next, __typeof__(*pos), member);	\
+	     &pos->member != (head);					\
+	     pos = n, n = list_entry(n->member.next, __typeof__(*n), member))
+
+/* locks spin on the host too, irqsave has no interrupts to mask */
+typedef struct {
+	volatile int locked;
+} spinlock_t;
+
+typedef spinlock_t raw_spinlock_t;
+
+#define __SPIN_LOCK_UNLOCKED(x)	{ 0 }
+#define DEFINE_SPINLOCK(x)	spinlock_t x = __SPIN_LOCK_UNLOCKED(x)
+
+static inline void spin_lock_init(spinlock_t *lock)
+{
+	lock->locked = 0;
+}
+
+static inline int spin_trylock(spinlock_t *lock)
+{
+	return !__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void spin_lock(spinlock_t *lock)
+{
+	while (!spin_trylock(lock))
+		while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED))
+			;
+}
+
+static inline void spin_unlock(spinlock_t *lock)
+{
+	__atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+#define spin_lock_irqsave(l, f)		do { (f) = 0; spin_lock(l); } while (0)
+#define spin_unlock_irqrestore(l, f)	do { (void)(f); spin_unlock(l); } while (0)
+#define raw_spin_lock_init(l)		spin_lock_init(l)
+#define raw_spin_trylock(l)		spin_trylock(l)
+#define raw_spin_lock(l)		spin_lock(l)
+#define raw_spin_unlock(l)		spin_unlock(l)
+#define raw_spin_lock_irqsave(l, f)	spin_lock_irqsave(l, f)
+#define raw_spin_unlock_irqrestore(l, f) spin_unlock_irqrestore(l, f)
+#define raw_spin_trylock_irqsave(l, f)	({ (f) = 0; spin_trylock(l); })
+
+static inline u64 ktime_get_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* register access goes to the model */
+#include "nx-gpio-sim.h"
+
+#define readl(a)		nx_sim_readl((const volatile void *)(a))
+#define writel(v, a)		nx_sim_writel((u32)(v), (volatile void *)(a))
+#define readl_relaxed(a)	readl(a)
+#define writel_relaxed(v, a)	writel(v, a)
+#define __raw_readl(a)		readl(a)
+#define __raw_writel(v, a)	writel(v, a)
+#define ioread32(a)		readl(a)
+#define iowrite32(v, a)		writel(v, a)
+#define dmb(...)		__sync_synchronize()
+
+/* irq core */
+typedef unsigned long irq_hw_number_t;
+
+typedef enum irqreturn {
+	IRQ_NONE		= 0,
+	IRQ_HANDLED		= 1,
+	IRQ_WAKE_THREAD		= 2,
+} irqreturn_t;
+
+typedef irqreturn_t (*irq_handler_t)(int, void *);
+
+#define IRQ_TYPE_NONE		0x00
+#define IRQ_TYPE_EDGE_RISING	0x01
+#define IRQ_TYPE_EDGE_FALLING	0x02
+#define IRQ_TYPE_EDGE_BOTH	(IRQ_TYPE_EDGE_FALLING | IRQ_TYPE_EDGE_RISING)
+#define IRQ_TYPE_LEVEL_HIGH	0x04
+#define IRQ_TYPE_LEVEL_LOW	0x08
+#define IRQ_TYPE_SENSE_MASK	0x0f
+
+#define IRQCHIP_SKIP_SET_WAKE	(1 << 4)
+
+struct irq_chip;
+
+struct irq_data {
+	unsigned int irq;
+	irq_hw_number_t hwirq;
+	struct irq_chip *chip;
+	void *chip_data;
+};
+
+struct irq_chip {
+	const char *name;
+	void (*irq_enable)(struct irq_data *);
+	void (*irq_disable)(struct irq_data *);
+	void (*irq_ack)(struct irq_data *);
+	void (*irq_mask)(struct irq_data *);
+	void (*irq_unmask)(struct irq_data *);
+	int (*irq_set_type)(struct irq_data *, unsigned int);
+	int (*irq_set_wake)(struct irq_data *, unsigned int);
+	unsigned long flags;
+};
+
+struct irq_desc;
+typedef void (*irq_flow_handler_t)(struct irq_desc *);
+
+struct irq_desc {
+	struct irq_data irq_data;
+	irq_flow_handler_t handle_irq;
+	irq_handler_t action;
+	void *dev_id;
+	unsigned long count;	/* flow handler entries */
+};
+
+struct irq_domain;
+
+struct irq_domain_ops {
+	int (*map)(struct irq_domain *, unsigned int, irq_hw_number_t);
+	int (*xlate)(struct irq_domain *, struct device_node *, const u32 *,
+		     unsigned int, irq_hw_number_t *, unsigned int *);
+};
+
+struct irq_domain {
+	const struct irq_domain_ops *ops;
+	void *host_data;
+	unsigned int revmap_size;
+	unsigned int virq_base;
+};
+
+#define SIM_NR_IRQS	512
+
+struct irq_desc *irq_to_desc(unsigned int irq);
+struct irq_data *irq_get_irq_data(unsigned int irq);
+int irq_set_chip_data(unsigned int irq, void *data);
+void irq_set_chip_and_handler(unsigned int irq, struct irq_chip *chip,
+			      irq_flow_handler_t handle);
+void handle_level_irq(struct irq_desc *desc);
+void handle_edge_irq(struct irq_desc *desc);
+int generic_handle_irq(unsigned int irq);
+struct irq_domain *irq_domain_add_linear(struct device_node *of_node,
+					 unsigned int size,
+					 const struct irq_domain_ops *ops,
+					 void *host_data);
+void irq_domain_remove(struct irq_domain *domain);
+int irq_domain_xlate_twocell(struct irq_domain *d, struct device_node *node,
+			     const u32 *intspec, unsigned int intsize,
+			     irq_hw_number_t *out_hwirq, unsigned int *out_type);
+int devm_request_irq(struct device *dev, unsigned int irq,
+		     irq_handler_t handler, unsigned long flags,
+		     const char *name, void *dev_id);
+void devm_free_irq(struct device *dev, unsigned int irq, void *dev_id);
+int request_irq(unsigned int irq, irq_handler_t handler, unsigned long flags,
+		const char *name, void *dev_id);
+
+/* run the handler registered on a parent irq, like the GIC would */
+irqreturn_t sim_raise_irq(unsigned int irq);
+
+static inline void *irq_data_get_irq_chip_data(struct irq_data *d)
+{
+	return d->chip_data;
+}
+
+static inline unsigned int irq_linear_revmap(struct irq_domain *domain,
+					     irq_hw_number_t hwirq)
+{
+	return hwirq < domain->revmap_size ? domain->virq_base + hwirq : 0;
+}
+
+/* gpiolib and pinctrl types embedded in the nexell structures */
+struct gpio_chip {
+	const char *label;
+	struct device *dev;
+	int (*request)(struct gpio_chip *chip, unsigned offset);
+	void (*free)(struct gpio_chip *chip, unsigned offset);
+	int (*direction_input)(struct gpio_chip *chip, unsigned offset);
+	int (*direction_output)(struct gpio_chip *chip, unsigned offset,
+				int value);
+	int (*get)(struct gpio_chip *chip, unsigned offset);
+	void (*set)(struct gpio_chip *chip, unsigned offset, int value);
+	void (*set_multiple)(struct gpio_chip *chip, unsigned long *mask,
+			     unsigned long *bits);
+	int (*to_irq)(struct gpio_chip *chip, unsigned offset);
+	int base;
+	u16 ngpio;
+};
+
+struct pinctrl_gpio_range {
+	const char *name;
+	unsigned int id;
+	unsigned int base;
+	unsigned int pin_base;
+	unsigned int npins;
+	struct gpio_chip *gc;
+};
+
+struct pinctrl_desc {
+	const char *name;
+};
+
+struct pinctrl_dev;
+
+/* debugfs files are never created, seq_file shows print to a stdio stream */
+#define THIS_MODULE	NULL
+
+struct inode {
+	void *i_private;
+};
+
+struct file;
+struct dentry;
+
+struct seq_file {
+	FILE *stream;
+	void *private;
+};
+
+#define seq_printf(m, ...)	fprintf((m)->stream, __VA_ARGS__)
+
+struct file_operations {
+	void *owner;
+	int (*open)(struct inode *inode, struct file *file);
+	long (*read)(struct file *file, char __user *buf, size_t len,
+		     long long *pos);
+	long long (*llseek)(struct file *file, long long off, int whence);
+	int (*release)(struct inode *inode, struct file *file);
+};
+
+static inline int single_open(struct file *file,
+			      int (*show)(struct seq_file *, void *),
+			      void *data)
+{
+	return -ENODEV;
+}
+
+#define seq_read	NULL
+#define seq_lseek	NULL
+#define single_release	NULL
+
+static inline struct dentry *debugfs_create_file(const char *name,
+		unsigned short mode, struct dentry *parent, void *data,
+		const struct file_operations *fops)
+{
+	return NULL;
+}
+
+#endif /* __SIM_KERNEL_H */
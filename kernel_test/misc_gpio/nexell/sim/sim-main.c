@@ -0,0 +1,546 @@
+/*
+ * Host harness for the s5pxx18 pinctrl code on the register model.
+ *
+ *   nx-gpio-sim check
+ *	probe the banks on the model and verify output, input, irq and
+ *	alive SET/RESET behaviour, exits non zero on the first mismatch
+ *
+ *   nx-gpio-sim bench [loops] [read_ns] [write_ns]
+ *	time the nx_soc_gpio_* accessors and the bank irq demux in ns and
+ *	cpu cycles and count register accesses per operation, read_ns/
+ *	write_ns add a busy-wait per access to emulate device-mapped
+ *	latency. The storm rows fire
+ *	bursts of simultaneous edges and count parent irq entries per
+ *	child irq. The thread rows toggle two pins from two threads, on
+ *	one bank and on two banks, and print the bank lock statistics.
+ *	The 8 pin rows compare per-pin accessors with the masked
+ *	whole-bank ones behind gpiolib set_multiple/get_multiple
+ *
+ * The driver source is included so its static functions can be driven
+ * directly, exactly as they are built for the kernel.
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include "../pinctrl-s5pxx18.c"
+#include "gpio_misc_driver.h"
+
+#define SIM_PARENT_IRQ(i)	(32 + (i))
+
+static struct device sim_dev = { .name = "sim-pinctrl" };
+static struct nexell_pinctrl_drv_data sim_drv;
+static struct nexell_pin_ctrl *sim_ctrl;
+
+static unsigned long child_hits[SIM_NR_IRQS];
+static int failures;
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__FILE__, __LINE__, #cond);		\
+			failures++;					\
+		}							\
+	} while (0)
+
+static u64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* cpu cycle counter, falls back to ns where there is none */
+static u64 now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+	u64 cnt;
+
+	asm volatile("mrs %0, cntvct_el0" : "=r" (cnt));
+	return cnt;
+#else
+	return now_ns();
+#endif
+}
+
+/* what nexell_pinctrl_probe() does with the DT resources */
+static int sim_probe(void)
+{
+	struct nexell_pin_bank *bank;
+	unsigned int i;
+	int ret;
+
+	nx_sim_reset();
+
+	sim_ctrl = (struct nexell_pin_ctrl *)s5pxx18_pin_ctrl;
+	sim_drv.ctrl = sim_ctrl;
+	sim_drv.dev = &sim_dev;
+
+	for (i = 0; i < sim_ctrl->nr_banks; i++) {
+		bank = &sim_ctrl->pin_banks[i];
+		bank->pin_base = i * GPIO_NUM_PER_BANK;
+		bank->grange.pin_base = bank->pin_base;
+		bank->drvdata = &sim_drv;
+		bank->irq = SIM_PARENT_IRQ(i);
+		bank->virt_base = bank->eint_type == EINT_TYPE_WKUP ?
+				  nx_sim_alive_base() : nx_sim_gpio_base(i);
+	}
+
+	ret = sim_ctrl->base_init(&sim_drv);
+	if (!ret)
+		ret = sim_ctrl->gpio_irq_init(&sim_drv);
+	if (!ret)
+		ret = sim_ctrl->alive_irq_init(&sim_drv);
+	return ret;
+}
+
+static struct nexell_pin_bank *sim_bank(unsigned int io)
+{
+	return &sim_ctrl->pin_banks[PAD_GET_GROUP(io)];
+}
+
+static irqreturn_t sim_child_handler(int irq, void *dev_id)
+{
+	child_hits[irq]++;
+	return IRQ_HANDLED;
+}
+
+/* request_irq() on a pin: set the trigger and enable it like irq_startup */
+static unsigned int sim_request_pin_irq(unsigned int io, unsigned int type)
+{
+	struct nexell_pin_bank *bank = sim_bank(io);
+	unsigned int virq = irq_linear_revmap(bank->irq_domain,
+					      PAD_GET_BITNO(io));
+	struct irq_data *d = irq_get_irq_data(virq);
+
+	request_irq(virq, sim_child_handler, 0, "sim", NULL);
+	d->chip->irq_set_type(d, type);
+	d->chip->irq_enable(d);
+	child_hits[virq] = 0;
+	return virq;
+}
+
+/* deliver bank irqs until every line is quiet, returns parent entries */
+static unsigned long sim_dispatch(void)
+{
+	unsigned long entries = 0;
+	unsigned int i;
+	u32 lines;
+
+	while ((lines = nx_sim_irq_lines()) && entries < 1000000) {
+		for (i = 0; i < sim_ctrl->nr_banks; i++) {
+			if (!(lines & BIT(i)))
+				continue;
+			sim_raise_irq(sim_ctrl->pin_banks[i].irq);
+			entries++;
+		}
+	}
+	return entries;
+}
+
+static void sim_drive_pin(unsigned int io, int level)
+{
+	nx_sim_drive(PAD_GET_GROUP(io), BIT(PAD_GET_BITNO(io)),
+		     level ? BIT(PAD_GET_BITNO(io)) : 0);
+}
+
+struct sim_toggler {
+	pthread_t thread;
+	unsigned int io;
+	unsigned long loops;
+};
+
+/* toggle one output pin loops times, leaving it high */
+static void *sim_toggle(void *arg)
+{
+	struct sim_toggler *t = arg;
+	unsigned long n;
+
+	for (n = 0; n < t->loops; n++)
+		nx_soc_gpio_set_out_value(t->io, !(n & 1));
+	nx_soc_gpio_set_out_value(t->io, 1);
+	return NULL;
+}
+
+/* run sim_toggle on io_a and io_b concurrently */
+static void sim_toggle_pair(unsigned int io_a, unsigned int io_b,
+			    unsigned long loops)
+{
+	struct sim_toggler t[2] = {
+		{ .io = io_a, .loops = loops },
+		{ .io = io_b, .loops = loops },
+	};
+	int i;
+
+	for (i = 0; i < 2; i++)
+		pthread_create(&t[i].thread, NULL, sim_toggle, &t[i]);
+	for (i = 0; i < 2; i++)
+		pthread_join(t[i].thread, NULL);
+}
+
+static void sim_lockstat_reset(void)
+{
+	struct nexell_pin_bank *bank = sim_ctrl->pin_banks;
+	unsigned int i;
+
+	for (i = 0; i < sim_ctrl->nr_banks; i++, bank++) {
+		bank->lock_acquired = 0;
+		bank->lock_contended = 0;
+		bank->lock_wait_ns = 0;
+	}
+}
+
+static int run_check(void)
+{
+	struct nx_alive_gpio_regs *misc = nx_sim_alive_base();
+	struct nx_alive_reg_set *alive = nx_sim_alive_base();
+	unsigned int out = PAD_GPIO_B + 3, in = PAD_GPIO_C + 5;
+	unsigned int alv = PAD_GPIO_ALV + 2, virq, revmap;
+	struct nx_gpio_reg_set *regs = nx_sim_gpio_base(1), saved;
+	int i;
+
+	if (sim_probe()) {
+		fprintf(stderr, "probe failed\n");
+		return 1;
+	}
+
+	/* gpio bank output follows OUT only while OUTENB is set */
+	nx_soc_gpio_set_io_func(out, nx_soc_gpio_get_altnum(out));
+	nx_soc_gpio_set_out_value(out, 1);
+	CHECK(nx_soc_gpio_get_in_value(out) == 0);
+	nx_soc_gpio_set_io_dir(out, 1);
+	CHECK(nx_soc_gpio_get_io_dir(out) == 1);
+	CHECK(nx_soc_gpio_get_in_value(out) == 1);
+	nx_soc_gpio_set_out_value(out, 0);
+	CHECK(nx_soc_gpio_get_in_value(out) == 0);
+	CHECK(nx_soc_gpio_get_out_value(out) == 0);
+
+	/* gpio bank input and rising edge detect through the demux */
+	nx_soc_gpio_set_io_dir(in, 0);
+	virq = sim_request_pin_irq(in, IRQ_TYPE_EDGE_RISING);
+	sim_drive_pin(in, 1);
+	CHECK(nx_soc_gpio_get_in_value(in) == 1);
+	CHECK(nx_soc_gpio_get_int_pend(in) == 1);
+	CHECK(sim_dispatch() == 1);
+	CHECK(child_hits[virq] == 1);
+	CHECK(nx_soc_gpio_get_int_pend(in) == 0);
+	sim_drive_pin(in, 0);
+	CHECK(sim_dispatch() == 0);
+	CHECK(child_hits[virq] == 1);
+
+	/* both edges */
+	virq = sim_request_pin_irq(in, IRQ_TYPE_EDGE_BOTH);
+	sim_drive_pin(in, 1);
+	sim_drive_pin(in, 0);
+	sim_dispatch();
+	sim_drive_pin(in, 1);
+	sim_dispatch();
+	CHECK(child_hits[virq] == 2);
+	sim_drive_pin(in, 0);
+	sim_dispatch();
+
+	/* a burst on several pins of a bank drains in one parent entry */
+	virq = sim_request_pin_irq(PAD_GPIO_D + 1, IRQ_TYPE_EDGE_RISING);
+	sim_request_pin_irq(PAD_GPIO_D + 7, IRQ_TYPE_EDGE_RISING);
+	nx_sim_drive(PAD_GET_GROUP(PAD_GPIO_D), BIT(1) | BIT(7), BIT(1) | BIT(7));
+	CHECK(sim_dispatch() == 1);
+	CHECK(child_hits[virq] == 1 && child_hits[virq + 6] == 1);
+	nx_sim_drive(PAD_GET_GROUP(PAD_GPIO_D), BIT(1) | BIT(7), 0);
+
+	/* a parent entry with nothing pending is counted as unknown */
+	CHECK(sim_raise_irq(sim_bank(PAD_GPIO_D)->irq) == IRQ_NONE);
+	CHECK(sim_bank(PAD_GPIO_D)->irq_unknown == 1);
+
+	/* an enabled pin with no mapping is acked, not unknown */
+	revmap = sim_bank(PAD_GPIO_D)->irq_domain->revmap_size;
+	sim_bank(PAD_GPIO_D)->irq_domain->revmap_size = 7;
+	nx_sim_drive(PAD_GET_GROUP(PAD_GPIO_D), BIT(7), BIT(7));
+	CHECK(sim_raise_irq(sim_bank(PAD_GPIO_D)->irq) == IRQ_HANDLED);
+	CHECK(sim_bank(PAD_GPIO_D)->irq_spurious == 1);
+	CHECK(sim_bank(PAD_GPIO_D)->irq_unknown == 1);
+	CHECK(nx_soc_gpio_get_int_pend(PAD_GPIO_D + 7) == 0);
+	nx_sim_drive(PAD_GET_GROUP(PAD_GPIO_D), BIT(7), 0);
+	sim_bank(PAD_GPIO_D)->irq_domain->revmap_size = revmap;
+
+	/* alive output through the SET/RESET pairs */
+	nx_soc_gpio_set_io_dir(alv, 1);
+	CHECK(alive->ALIVEGPIOPADOUTENBREADREG == BIT(2));
+	nx_soc_gpio_set_out_value(alv, 1);
+	CHECK(alive->ALIVEGPIOPADOUTREADREG == BIT(2));
+	CHECK(nx_soc_gpio_get_in_value(alv) == 1);
+	nx_soc_gpio_set_out_value(alv, 0);
+	CHECK(alive->ALIVEGPIOPADOUTREADREG == 0);
+	CHECK(nx_soc_gpio_get_in_value(alv) == 0);
+	nx_soc_gpio_set_io_dir(alv, 0);
+
+	/* alive rising edge detect */
+	virq = sim_request_pin_irq(PAD_GPIO_ALV + 4, IRQ_TYPE_EDGE_RISING);
+	nx_sim_drive(ALIVE_INDEX, BIT(4), BIT(4));
+	CHECK(nx_soc_alive_get_int_pend(PAD_GPIO_ALV + 4) == 1);
+	CHECK(sim_dispatch() == 1);
+	CHECK(child_hits[virq] == 1);
+	CHECK(nx_soc_alive_get_int_pend(PAD_GPIO_ALV + 4) == 0);
+	nx_sim_drive(ALIVE_INDEX, BIT(4), 0);
+
+	/* the misc driver register accessors on the same alive block */
+	misc_setbit(&misc->outputenb, 1);
+	misc_setbit(&misc->data, 1);
+	CHECK(misc_getbit(&misc->pad, 1) == 1);
+	CHECK(misc_getbit(&misc->outputenb_read, 1) == 1);
+	misc_setbit(&misc->pad_reset, 1);
+	CHECK(misc_getbit(&misc->pad, 1) == 0);
+	misc_setbit(&misc->outputenb_reset, 1);
+	CHECK(misc_getbit(&misc->outputenb_read, 1) == 0);
+
+	/* the detect registers the misc driver snapshots over suspend */
+	CHECK((void *)&misc->detmode[NX_ALIVE_DET_RISING].read ==
+	      (void *)&alive->ALIVEGPIORISEDETECTMODEREADREG);
+	CHECK((void *)&misc->detenb.read ==
+	      (void *)&alive->ALIVEGPIODETECTENBREADREG);
+	CHECK((void *)&misc->intenb.read ==
+	      (void *)&alive->ALIVEGPIOINTENBREADREG);
+	CHECK((void *)&misc->pend == (void *)&alive->ALIVEGPIODETECTPENDREG);
+	alive_gpio_rsr_write(&misc->detmode[NX_ALIVE_DET_FALLING], BIT(6) | BIT(7),
+			     BIT(6));
+	CHECK(alive->ALIVEGPIOFALLDETECTMODEREADREG == BIT(6));
+
+	/* masked whole-bank updates touch only the masked pins */
+	nx_soc_gpio_set_out_values(PAD_GPIO_E, 0xff00, 0xa5a5);
+	CHECK((((struct nx_gpio_reg_set *)nx_sim_gpio_base(4))->GPIOxOUT &
+	       0xff00) == 0xa500);
+	nx_sim_drive(2, 0xf0, 0x50);
+	CHECK((nx_soc_gpio_get_in_values(PAD_GPIO_C + 7) & 0xf0) == 0x50);
+	nx_soc_gpio_set_out_values(PAD_GPIO_ALV, 0x3f, 0x15);
+	CHECK(alive->ALIVEGPIOPADOUTREADREG == 0x15);
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	nx_soc_gpio_set_out_values(PAD_GPIO_ALV, 0x3, 0x3);
+	CHECK(alive->ALIVEGPIOPADOUTREADREG == 0x17);
+	CHECK(nx_sim_stats.writes == 1 && nx_sim_stats.reads == 0);
+	nx_soc_gpio_set_out_values(PAD_GPIO_ALV, 0x3f, 0);
+
+	/* config writes go through the shadow, suspend reads nothing back */
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	nx_soc_gpio_set_io_pull(PAD_GPIO_B + 9, 1);
+	nx_soc_gpio_set_io_drv(PAD_GPIO_B + 9, 3);
+	nx_soc_gpio_set_io_func(PAD_GPIO_B + 20, 2);
+	CHECK(nx_sim_stats.reads == 0);
+	CHECK(nx_soc_gpio_get_io_pull(PAD_GPIO_B + 9) == 1);
+	CHECK(nx_soc_gpio_get_io_drv(PAD_GPIO_B + 9) == 3);
+	CHECK(nx_soc_gpio_get_io_func(PAD_GPIO_B + 20) == 2);
+
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	nx_soc_gpio_set_io_func(PAD_GPIO_B + 20, 2);
+	CHECK(nx_sim_stats.writes == 0);
+
+	saved = *regs;
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	for (i = 0; i < NUMBER_OF_GPIO_MODULE; i++)
+		CHECK(s5pxx18_gpio_suspend(i) == 0);
+	CHECK(nx_sim_stats.reads == 0);
+
+	/* the bank loses its state while powered down */
+	memset(regs, 0, sizeof(*regs));
+	CHECK(s5pxx18_gpio_resume(1) == 0);
+	CHECK(regs->GPIOxOUT == saved.GPIOxOUT);
+	CHECK(regs->GPIOxOUTENB == saved.GPIOxOUTENB);
+	CHECK(!memcmp(regs->GPIOxALTFN, saved.GPIOxALTFN,
+		      sizeof(saved.GPIOxALTFN)));
+	CHECK(regs->GPIOx_PULLSEL == saved.GPIOx_PULLSEL);
+	CHECK(regs->GPIOx_PULLENB == saved.GPIOx_PULLENB);
+	CHECK(regs->GPIOx_DRV0 == saved.GPIOx_DRV0);
+	CHECK(regs->GPIOx_DRV1 == saved.GPIOx_DRV1);
+	CHECK(regs->GPIOxINTENB == saved.GPIOxINTENB);
+	CHECK(regs->GPIOxDETENB == saved.GPIOxDETENB);
+
+	/* two threads updating one bank's OUT register lose no bits */
+	nx_soc_gpio_set_io_dir(PAD_GPIO_E + 1, 1);
+	nx_soc_gpio_set_io_dir(PAD_GPIO_E + 2, 1);
+	sim_lockstat_reset();
+	sim_toggle_pair(PAD_GPIO_E + 1, PAD_GPIO_E + 2, 100000);
+	CHECK((((struct nx_gpio_reg_set *)nx_sim_gpio_base(4))->GPIOxOUT &
+	       (BIT(1) | BIT(2))) == (BIT(1) | BIT(2)));
+	CHECK(sim_bank(PAD_GPIO_E)->lock_acquired == 2 * (100000 + 1));
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures ? 1 : 0;
+}
+
+static void bench_report(const char *name, unsigned long loops, u64 ns,
+			 u64 cycles, const struct nx_sim_stats *st)
+{
+	printf("%-28s %10.1f ns/op %8.1f cyc/op %6.2f rd/op %6.2f wr/op\n",
+	       name, (double)ns / loops, (double)cycles / loops,
+	       (double)st->reads / loops, (double)st->writes / loops);
+}
+
+/*
+ * bursts of npins simultaneous edges on one bank starting at io, every
+ * pin set to both edges, reports parent irq entries per child irq
+ */
+static void bench_storm(const char *name, unsigned int io, unsigned int npins,
+			unsigned long bursts)
+{
+	unsigned int virq[GPIO_NUM_PER_BANK], i;
+	unsigned long entries = 0, children = 0, n;
+	u32 mask = 0;
+	u64 t0;
+
+	for (i = 0; i < npins; i++) {
+		virq[i] = sim_request_pin_irq(io + i, IRQ_TYPE_EDGE_BOTH);
+		mask |= BIT(PAD_GET_BITNO(io + i));
+	}
+
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	t0 = now_ns();
+	for (n = 0; n < bursts; n++) {
+		nx_sim_drive(PAD_GET_GROUP(io), mask, n & 1 ? 0 : mask);
+		entries += sim_dispatch();
+	}
+	t0 = now_ns() - t0;
+
+	for (i = 0; i < npins; i++) {
+		children += child_hits[virq[i]];
+		irq_get_irq_data(virq[i])->chip->irq_disable(
+			irq_get_irq_data(virq[i]));
+		devm_free_irq(NULL, virq[i], NULL);
+	}
+
+	printf("%-28s %10.1f ns/irq %6.2f entries/irq %6.2f rd/irq\n", name,
+	       children ? (double)t0 / children : 0.0,
+	       children ? (double)entries / children : 0.0,
+	       children ? (double)nx_sim_stats.reads / children : 0.0);
+}
+
+/* two threads toggling io_a and io_b, reports ns per toggle */
+static void bench_threads(const char *name, unsigned int io_a,
+			  unsigned int io_b, unsigned long loops)
+{
+	struct nx_sim_stats st;
+	u64 t0, c0;
+
+	memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));
+	t0 = now_ns();
+	c0 = now_cycles();
+	sim_toggle_pair(io_a, io_b, loops);
+	c0 = now_cycles() - c0;
+	t0 = now_ns() - t0;
+	st = nx_sim_stats;
+	bench_report(name, 2 * (loops + 1), t0, c0, &st);
+}
+
+#define BENCH(name, loops, body)					\
+	do {								\
+		struct nx_sim_stats st;					\
+		unsigned long n;					\
+		u64 t0, c0;						\
+									\
+		memset(&nx_sim_stats, 0, sizeof(nx_sim_stats));		\
+		t0 = now_ns();						\
+		c0 = now_cycles();					\
+		for (n = 0; n < (loops); n++)				\
+			body;						\
+		c0 = now_cycles() - c0;					\
+		t0 = now_ns() - t0;					\
+		st = nx_sim_stats;					\
+		bench_report(name, loops, t0, c0, &st);			\
+	} while (0)
+
+static void set_pins(unsigned int io, unsigned int npins, u32 values)
+{
+	unsigned int i;
+
+	for (i = 0; i < npins; i++)
+		nx_soc_gpio_set_out_value(io + i, values & BIT(i));
+}
+
+static u32 get_pins(unsigned int io, unsigned int npins)
+{
+	unsigned int i;
+	u32 values = 0;
+
+	for (i = 0; i < npins; i++)
+		values |= (u32)nx_soc_gpio_get_in_value(io + i) << i;
+	return values;
+}
+
+static int run_bench(unsigned long loops, unsigned int rd_ns,
+		     unsigned int wr_ns)
+{
+	unsigned int out = PAD_GPIO_B + 3, in = PAD_GPIO_C + 5;
+	unsigned int alv = PAD_GPIO_ALV + 2;
+	unsigned int i;
+
+	if (sim_probe()) {
+		fprintf(stderr, "probe failed\n");
+		return 1;
+	}
+	nx_sim_set_latency(rd_ns, wr_ns);
+
+	printf("loops %lu, read %u ns, write %u ns\n", loops, rd_ns, wr_ns);
+
+	nx_soc_gpio_set_io_dir(out, 1);
+	nx_soc_gpio_set_io_dir(alv, 1);
+	sim_request_pin_irq(in, IRQ_TYPE_EDGE_BOTH);
+
+	BENCH("gpio set_out_value", loops,
+	      nx_soc_gpio_set_out_value(out, n & 1));
+	BENCH("gpio get_in_value", loops, nx_soc_gpio_get_in_value(in));
+	BENCH("gpio get_out_value", loops, nx_soc_gpio_get_out_value(out));
+	BENCH("gpio set_io_dir", loops, nx_soc_gpio_set_io_dir(out, 1));
+	BENCH("gpio get_io_dir", loops, nx_soc_gpio_get_io_dir(out));
+	BENCH("alive set_out_value", loops,
+	      nx_soc_gpio_set_out_value(alv, n & 1));
+	BENCH("alive get_in_value", loops, nx_soc_gpio_get_in_value(alv));
+	BENCH("alive set_io_dir", loops, nx_soc_gpio_set_io_dir(alv, 1));
+	BENCH("gpio edge + demux", loops,
+	      (sim_drive_pin(in, !(n & 1)), sim_dispatch()));
+
+	for (i = 0; i < 8; i++)
+		nx_soc_gpio_set_io_dir(PAD_GPIO_A + 8 + i, 1);
+	BENCH("gpio set 8 pins per-pin", loops / 8,
+	      set_pins(PAD_GPIO_A + 8, 8, n));
+	BENCH("gpio set 8 pins masked", loops / 8,
+	      nx_soc_gpio_set_out_values(PAD_GPIO_A, 0xff00, n << 8));
+	BENCH("gpio get 8 pins per-pin", loops / 8,
+	      get_pins(PAD_GPIO_A + 8, 8));
+	BENCH("gpio get 8 pins masked", loops / 8,
+	      nx_soc_gpio_get_in_values(PAD_GPIO_A));
+	BENCH("alive set 6 pins per-pin", loops / 8,
+	      set_pins(PAD_GPIO_ALV, 6, n));
+	BENCH("alive set 6 pins masked", loops / 8,
+	      nx_soc_gpio_set_out_values(PAD_GPIO_ALV, 0x3f, n));
+
+	bench_storm("gpio storm 1 pin", PAD_GPIO_D, 1, loops / 32);
+	bench_storm("gpio storm 8 pins", PAD_GPIO_D, 8, loops / 32);
+	bench_storm("gpio storm 32 pins", PAD_GPIO_D, 32, loops / 32);
+	bench_storm("alive storm 6 pins", PAD_GPIO_ALV, 6, loops / 32);
+
+	nx_soc_gpio_set_io_dir(PAD_GPIO_B + 4, 1);
+	nx_soc_gpio_set_io_dir(PAD_GPIO_E + 4, 1);
+	sim_lockstat_reset();
+	bench_threads("gpio 2 threads 1 bank", out, PAD_GPIO_B + 4, loops);
+	bench_threads("gpio 2 threads 2 banks", out, PAD_GPIO_E + 4, loops);
+	s5pxx18_lockstat_show(&(struct seq_file){ stdout, &sim_drv }, NULL);
+
+	nx_sim_set_latency(0, 0);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && !strcmp(argv[1], "check"))
+		return run_check();
+
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return run_bench(argc > 2 ? strtoul(argv[2], NULL, 0) : 1000000,
+				 argc > 3 ? strtoul(argv[3], NULL, 0) : 0,
+				 argc > 4 ? strtoul(argv[4], NULL, 0) : 0);
+
+	fprintf(stderr, "usage: %s check | bench [loops] [read_ns] [write_ns]\n",
+		argv[0]);
+	return 1;
+}
@@ -12,51 +12,37 @@
 #include <linux/jiffies.h>
 
 
+//LED is connected to this GPIO
+#define GPIO_162 (162)
+#define GPIO_163 (163)
+
 #define EN_DEBOUNCE
 #ifdef EN_DEBOUNCE
+#include "debounce.h"
 
-extern unsigned long volatile jiffies;
-unsigned long old_jiffie = 0;
+static struct debounce_pin debounce_pins[] = {
+  { .gpio = GPIO_163, .active_level = 1, .window_us = 20 * USEC_PER_MSEC },
+};
 #endif
 
-//LED is connected to this GPIO
-#define GPIO_162 (162)
-#define GPIO_163 (163)
-
 //GPIO_163 value toggle
 unsigned int led_toggle = 0; 
 
 //This used for storing the IRQ number for the GPIO
 unsigned int GPIO_irqNumber;
 
-//Interrupt handler for GPIO 25. This will be called whenever there is a raising edge detected. 
+//Interrupt handler for GPIO 163. This will be called whenever there is a raising edge detected. 
 static irqreturn_t gpio_irq_handler(int irq, void *dev_id) 
 {
-
 #ifdef EN_DEBOUNCE
-   unsigned long diff = jiffies - old_jiffie;
-
-   if (diff < 20)
-   {
-    printk(KERN_NOTICE "Interrupt [%d] for device %s was triggered, jiffies=%lu, diff=%lu, direction: %d \n",
-          irq, (char *) dev_id, jiffies, diff, gpio_get_value(GPIO_162));
-
-    printk(KERN_NOTICE "Interrupt [%d] for device %s was triggered, jiffies=%lu, diff=%lu, direction: %d \n",
-          irq, (char *) dev_id, jiffies, diff, gpio_get_value(GPIO_163));
-
-    return IRQ_HANDLED;
-   }
-  
-  old_jiffie = jiffies;
-#endif  
-  
-  pr_info("Interrupt(IRQ Handler)\n");
-  
+  return debounce_edge(dev_id);
+#else
   /*
   ** If you don't want to call the thread fun, then you can just return
   ** IRQ_HANDLED. If you return IRQ_WAKE_THREAD, then thread fun will be called.
   */
   return IRQ_WAKE_THREAD;
+#endif
 }
 
 /*
@@ -72,6 +58,12 @@ static irqreturn_t gpio_interrupt_thread_fn(int irq, void *dev_id)
 }
 
 
+#ifdef EN_DEBOUNCE
+#define IRQ_DEV_ID (&debounce_pins[0])
+#else
+#define IRQ_DEV_ID NULL
+#endif
+
 dev_t dev = 0;
 static struct class *dev_class;
 static struct cdev cdev;
@@ -236,15 +228,23 @@ static int __init gpio_driver_init(void)
   //Get the IRQ number for our GPIO
   GPIO_irqNumber = gpio_to_irq(GPIO_163);
   pr_info("GPIO_irqNumber = %d\n", GPIO_irqNumber);
+
+#ifdef EN_DEBOUNCE
+  debounce_init(KBUILD_MODNAME, debounce_pins,
+                ARRAY_SIZE(debounce_pins), GPIO_irqNumber);
+#endif
   
   if (request_threaded_irq( GPIO_irqNumber,             //IRQ number
                             (void *)gpio_irq_handler,   //IRQ handler (Top half)
                             gpio_interrupt_thread_fn,   //IRQ Thread handler (Bottom half)
                             IRQF_TRIGGER_RISING,        //Handler will be called in raising edge
                             "my_device",                //used to identify the device name using this IRQ
-                            NULL))                      //device id for shared IRQ
+                            IRQ_DEV_ID))                //per-pin debounce state, NULL without it
   {
     pr_err("my_device: cannot register IRQ ");
+#ifdef EN_DEBOUNCE
+    debounce_exit(debounce_pins, ARRAY_SIZE(debounce_pins));
+#endif
     goto r_gpio_in;
   }
  
@@ -272,7 +272,10 @@ r_unreg:
 */ 
 static void __exit gpio_driver_exit(void)
 {
-    free_irq(GPIO_irqNumber,NULL);
+    free_irq(GPIO_irqNumber, IRQ_DEV_ID);
+#ifdef EN_DEBOUNCE
+    debounce_exit(debounce_pins, ARRAY_SIZE(debounce_pins));
+#endif
     gpio_free(GPIO_163);
     gpio_free(GPIO_162);
     device_destroy(dev_class, dev);